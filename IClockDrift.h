@@ -0,0 +1,16 @@
+// This file is released under CC0 1.0 license
+// License text can be found at http://creativecommons.org/publicdomain/zero/1.0/
+
+// Originally designed as part of sanear project
+
+#pragma once
+
+struct __declspec(uuid("8CA9BD22-1D2C-4B3D-A7D1-0E93ABDFE152"))
+IClockDrift : IUnknown
+{
+    // Rate of the audio device clock against the system performance counter, in parts per million,
+    // along with the standard error of the estimate. Positive drift means the device runs fast.
+    // Suitable for IGuidedReclock::SlaveClock() as (1.0 + driftPpm / 1000000.0).
+    // Fails until enough of the stream has been played to tell.
+    STDMETHOD(GetClockDrift)(DOUBLE* pDriftPpm, DOUBLE* pErrorPpm) = 0;
+};
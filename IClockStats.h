@@ -0,0 +1,31 @@
+// This file is released under CC0 1.0 license
+// License text can be found at http://creativecommons.org/publicdomain/zero/1.0/
+
+// Originally designed as part of sanear project
+
+#pragma once
+
+struct __declspec(uuid("C0CF9DF1-2ED3-47E6-96CF-F5D8B3C0276C"))
+IClockStats : IUnknown
+{
+    enum
+    {
+        CLOCK_STATS_WARP,   // Jumps of the clock against the performance counter.
+        CLOCK_STATS_OFFSET, // Offsets applied to the clock to follow stream timestamps.
+        CLOCK_STATS_PAD,    // Silence inserted for rate or clock matching.
+        CLOCK_STATS_DROP,   // Audio dropped for rate or clock matching.
+        CLOCK_STATS_COUNT,
+    };
+
+    // Histogram bins by magnitude, upper bounds are 0.1, 0.5, 1, 5, 10, 50 and 100ms, the last one is open.
+    enum
+    {
+        CLOCK_STATS_BINS = 8,
+    };
+
+    // Times are in 100ns units and accumulate magnitudes. pBins may be null, otherwise it
+    // receives CLOCK_STATS_BINS event counts.
+    STDMETHOD(GetClockStats)(UINT32 uKind, UINT64* pEvents, LONGLONG* pTotalTime, LONGLONG* pMaxTime,
+                             UINT64* pBins) = 0;
+    STDMETHOD(ResetClockStats)() = 0;
+};
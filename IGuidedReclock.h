@@ -15,3 +15,11 @@ IGuidedReclock : IUnknown
 
     STDMETHOD(GetImmediateTime)(LONGLONG* pTime) = 0;
 };
+
+struct __declspec(uuid("D76153F8-7426-4BDC-8E20-9515A3AECC43"))
+IGuidedReclock2 : IGuidedReclock
+{
+    // Time by which audio still trails the reclocked clock, negative if it's ahead.
+    // Offsets are worked off gradually with bounded pitch deviation, this is what remains.
+    STDMETHOD(GetResidualError)(LONGLONG* pError) = 0;
+};
@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "AdviseScheduler.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#   define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace SaneAudioRenderer
+{
+    AdviseScheduler::AdviseScheduler(GetTimeFunction getTime, HRESULT& result)
+        : m_getTime(getTime)
+    {
+        if (FAILED(result))
+            return;
+
+        if (static_cast<HANDLE>(m_wake) == NULL)
+        {
+            result = E_OUTOFMEMORY;
+            return;
+        }
+
+        // High resolution timers are available starting with Windows 10 1803.
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        m_highResolutionTimer = (m_timer != NULL);
+
+        if (!m_timer)
+            m_timer = CreateWaitableTimerW(nullptr, FALSE, nullptr);
+
+        if (!m_timer)
+            result = E_OUTOFMEMORY;
+    }
+
+    AdviseScheduler::~AdviseScheduler()
+    {
+        m_exit = true;
+        m_wake.Set();
+
+        if (m_thread.joinable())
+            m_thread.join();
+
+        if (m_timer)
+            CloseHandle(m_timer);
+    }
+
+    HRESULT AdviseScheduler::AdviseTime(REFERENCE_TIME time, HANDLE hEvent, DWORD_PTR* pCookie)
+    {
+        CheckPointer(pCookie, E_POINTER);
+
+        if (time <= 0 || !hEvent)
+            return E_INVALIDARG;
+
+        return AddAdvise({time, 0, hEvent, 0}, pCookie);
+    }
+
+    HRESULT AdviseScheduler::AdvisePeriodic(REFERENCE_TIME startTime, REFERENCE_TIME periodTime,
+                                            HANDLE hSemaphore, DWORD_PTR* pCookie)
+    {
+        CheckPointer(pCookie, E_POINTER);
+
+        if (startTime < 0 || periodTime <= 0 || !hSemaphore)
+            return E_INVALIDARG;
+
+        return AddAdvise({startTime, periodTime, hSemaphore, 0}, pCookie);
+    }
+
+    HRESULT AdviseScheduler::Unadvise(DWORD_PTR cookie)
+    {
+        CAutoLock lock(this);
+
+        auto it = std::find_if(m_advises.begin(), m_advises.end(),
+                               [&](const Advise& advise) { return advise.cookie == cookie; });
+
+        if (it == m_advises.end())
+            return S_FALSE;
+
+        m_advises.erase(it);
+        std::make_heap(m_advises.begin(), m_advises.end(), LaterAdvise);
+
+        return S_OK;
+    }
+
+    HRESULT AdviseScheduler::AddAdvise(const Advise& advise, DWORD_PTR* pCookie)
+    {
+        CAutoLock lock(this);
+
+        try
+        {
+            // The thread is started on first use, most graphs never ask for advises.
+            if (!m_thread.joinable())
+                m_thread = std::thread(std::bind(&AdviseScheduler::Run, this));
+
+            m_advises.push_back(advise);
+            m_advises.back().cookie = m_nextCookie++;
+            std::push_heap(m_advises.begin(), m_advises.end(), LaterAdvise);
+        }
+        catch (std::system_error&)
+        {
+            return E_OUTOFMEMORY;
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        *pCookie = m_advises.back().cookie;
+
+        if (m_advises.front().cookie == *pCookie)
+            m_wake.Set();
+
+        return S_OK;
+    }
+
+    void AdviseScheduler::Run()
+    {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+        std::unique_ptr<TimePeriodHelper> timePeriodHelper;
+        if (!m_highResolutionTimer)
+            timePeriodHelper = std::make_unique<TimePeriodHelper>(1);
+
+        while (!m_exit)
+        {
+            // Don't hold our lock while reading the clock, it has its own.
+            const REFERENCE_TIME now = m_getTime();
+
+            REFERENCE_TIME dueTime = 0;
+
+            {
+                CAutoLock lock(this);
+
+                while (!m_advises.empty() && m_advises.front().time <= now)
+                {
+                    std::pop_heap(m_advises.begin(), m_advises.end(), LaterAdvise);
+                    Advise& advise = m_advises.back();
+
+                    if (advise.period > 0)
+                    {
+                        ReleaseSemaphore(advise.handle, 1, nullptr);
+
+                        // Fire once when late, instead of in a burst.
+                        advise.time += advise.period;
+                        if (advise.time <= now)
+                            advise.time += (now - advise.time) / advise.period * advise.period + advise.period;
+
+                        std::push_heap(m_advises.begin(), m_advises.end(), LaterAdvise);
+                    }
+                    else
+                    {
+                        SetEvent(advise.handle);
+                        m_advises.pop_back();
+                    }
+                }
+
+                if (!m_advises.empty())
+                    dueTime = m_advises.front().time - now;
+            }
+
+            if (dueTime > 0)
+            {
+                // Negative due time is relative, in 100ns units.
+                LARGE_INTEGER timerDueTime;
+                timerDueTime.QuadPart = -dueTime;
+
+                if (SetWaitableTimer(m_timer, &timerDueTime, 0, nullptr, nullptr, FALSE))
+                {
+                    WaitForAny(INFINITE, m_wake, m_timer);
+                    CancelWaitableTimer(m_timer);
+                    continue;
+                }
+
+                m_wake.Wait((DWORD)std::max<REFERENCE_TIME>(1, dueTime / OneMillisecond));
+            }
+            else
+            {
+                m_wake.Wait();
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // Replaces the generic CBaseReferenceClock advise thread, which sleeps on coarse timers and
+    // doesn't notice when the clock it serves gets offset or reslaved.
+    class AdviseScheduler final
+        : private CCritSec
+    {
+    public:
+
+        using GetTimeFunction = std::function<REFERENCE_TIME(void)>;
+
+        AdviseScheduler(GetTimeFunction getTime, HRESULT& result);
+        AdviseScheduler(const AdviseScheduler&) = delete;
+        AdviseScheduler& operator=(const AdviseScheduler&) = delete;
+        ~AdviseScheduler();
+
+        HRESULT AdviseTime(REFERENCE_TIME time, HANDLE hEvent, DWORD_PTR* pCookie);
+        HRESULT AdvisePeriodic(REFERENCE_TIME startTime, REFERENCE_TIME periodTime,
+                               HANDLE hSemaphore, DWORD_PTR* pCookie);
+        HRESULT Unadvise(DWORD_PTR cookie);
+
+        // Deadlines are in clock time, the wait has to be recomputed when the clock jumps.
+        void ClockChanged() { m_wake.Set(); }
+
+    private:
+
+        struct Advise
+        {
+            REFERENCE_TIME time;
+            REFERENCE_TIME period;
+            HANDLE handle;
+            DWORD_PTR cookie;
+        };
+
+        static bool LaterAdvise(const Advise& left, const Advise& right) { return left.time > right.time; }
+
+        HRESULT AddAdvise(const Advise& advise, DWORD_PTR* pCookie);
+
+        void Run();
+
+        const GetTimeFunction m_getTime;
+
+        std::thread m_thread;
+        std::atomic<bool> m_exit = false;
+        CAMEvent m_wake;
+
+        HANDLE m_timer = NULL;
+        bool m_highResolutionTimer = false;
+
+        // Min-heap on time.
+        std::vector<Advise> m_advises;
+        DWORD_PTR m_nextCookie = 1;
+    };
+}
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "AudioClockModel.h"
+
+namespace SaneAudioRenderer
+{
+    namespace
+    {
+        const int64_t SampleInterval = 5 * OneMillisecond;
+
+        // Anything further off than that is a discontinuity, not drift.
+        const double MaxSlopeDeviation = 0.01;
+        const int64_t MaxResidual = 20 * OneMillisecond;
+    }
+
+    void AudioClockModel::Reset()
+    {
+        m_sampleCount = 0;
+        m_sampleHead = 0;
+        m_lastSampleRequest = INT64_MIN;
+        m_fitted = false;
+        m_predicted = false;
+    }
+
+    bool AudioClockModel::ShouldSample(int64_t counterTime)
+    {
+        if (m_fitted && counterTime - m_lastSampleRequest < SampleInterval)
+            return false;
+
+        m_lastSampleRequest = counterTime;
+        return true;
+    }
+
+    bool AudioClockModel::AddSample(int64_t counterTime, int64_t positionTime)
+    {
+        bool continuous = true;
+
+        if (m_fitted)
+        {
+            const double predicted = m_fitPositionTime + (counterTime - m_fitCounterTime) * m_fitSlope;
+
+            if (std::abs(predicted - positionTime) > MaxResidual)
+            {
+                // Device position jumped, start over from this sample.
+                DebugOut(ClassName(this), "discontinuity of", (positionTime - predicted) / 10000., "ms");
+                const int64_t lastSampleRequest = m_lastSampleRequest;
+                Reset();
+                m_lastSampleRequest = lastSampleRequest;
+                continuous = false;
+            }
+        }
+
+        m_samples[m_sampleHead] = {counterTime, positionTime};
+        m_sampleHead = (m_sampleHead + 1) % m_samples.size();
+        m_sampleCount = std::min(m_sampleCount + 1, m_samples.size());
+
+        Fit();
+
+        return continuous;
+    }
+
+    bool AudioClockModel::Predict(int64_t counterTime, int64_t& positionTime)
+    {
+        if (!m_fitted)
+            return false;
+
+        positionTime = (int64_t)(m_fitPositionTime + (counterTime - m_fitCounterTime) * m_fitSlope);
+
+        // Refitting must not take the clock back.
+        if (m_predicted && positionTime < m_lastPrediction)
+            positionTime = m_lastPrediction;
+
+        m_predicted = true;
+        m_lastPrediction = positionTime;
+
+        return true;
+    }
+
+    void AudioClockModel::Fit()
+    {
+        assert(m_sampleCount > 0);
+
+        const size_t last = (m_sampleHead + m_samples.size() - 1) % m_samples.size();
+        const Sample& newest = m_samples[last];
+
+        m_fitted = true;
+        m_fitCounterTime = newest.counterTime;
+
+        if (m_sampleCount < 4)
+        {
+            // Not enough history yet, follow the device at nominal speed.
+            m_fitPositionTime = (double)newest.positionTime;
+            m_fitSlope = 1.0;
+            return;
+        }
+
+        // Least squares, relative to the newest sample to keep precision.
+        double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+
+        for (size_t i = 0; i < m_sampleCount; i++)
+        {
+            const Sample& sample = m_samples[i];
+            const double x = (double)(sample.counterTime - newest.counterTime);
+            const double y = (double)(sample.positionTime - newest.positionTime);
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+
+        const double n = (double)m_sampleCount;
+        const double denominator = n * sumXX - sumX * sumX;
+
+        double slope = (denominator > 0.0) ? (n * sumXY - sumX * sumY) / denominator : 1.0;
+        slope = std::min(1.0 + MaxSlopeDeviation, std::max(1.0 - MaxSlopeDeviation, slope));
+
+        const double intercept = (sumY - slope * sumX) / n;
+
+        m_fitPositionTime = newest.positionTime + intercept;
+        m_fitSlope = slope;
+    }
+}
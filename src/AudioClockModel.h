@@ -0,0 +1,48 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // Fits a line through recent (counter time, device position) samples, so that the clock
+    // can be read between the sparse and period-quantized position updates of the driver.
+    class AudioClockModel final
+    {
+    public:
+
+        AudioClockModel() = default;
+        AudioClockModel(const AudioClockModel&) = delete;
+        AudioClockModel& operator=(const AudioClockModel&) = delete;
+
+        void Reset();
+
+        // Returns true if it's time to query the device again, rate limits driver calls.
+        bool ShouldSample(int64_t counterTime);
+        // Returns false if the sample didn't fit the model and it had to start over.
+        bool AddSample(int64_t counterTime, int64_t positionTime);
+
+        bool Predict(int64_t counterTime, int64_t& positionTime);
+
+    private:
+
+        void Fit();
+
+        struct Sample
+        {
+            int64_t counterTime;
+            int64_t positionTime;
+        };
+
+        std::array<Sample, 32> m_samples;
+        size_t m_sampleCount = 0;
+        size_t m_sampleHead = 0;
+
+        int64_t m_lastSampleRequest = INT64_MIN;
+
+        bool m_fitted = false;
+        int64_t m_fitCounterTime = 0;
+        double m_fitPositionTime = 0.0;
+        double m_fitSlope = 1.0;
+
+        bool m_predicted = false;
+        int64_t m_lastPrediction = 0;
+    };
+}
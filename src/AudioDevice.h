@@ -5,6 +5,8 @@
 
 namespace SaneAudioRenderer
 {
+    struct SimulatedAudioParameters;
+
     struct AudioDeviceBackend final
     {
         SharedString          id;
@@ -27,13 +29,20 @@ namespace SaneAudioRenderer
 
         REFERENCE_TIME        deviceLatency;
         UINT32                deviceBufferSize;
+        REFERENCE_TIME        devicePeriod;
 
         bool                  exclusive;
         bool                  bitstream;
         bool                  eventMode;
         bool                  realtime;
+        bool                  headless;
+        bool                  pauseSilence;
+        bool                  adaptiveBuffer;
+        uint32_t              lowLatencyPeriod;
 
         bool                  ignoredSystemChannelMixer;
+
+        std::shared_ptr<const SimulatedAudioParameters> simulation;
     };
 
     class AudioDevice
@@ -53,6 +62,27 @@ namespace SaneAudioRenderer
         virtual void Stop() = 0;
         virtual void Reset() = 0;
 
+        // Discards queued audio while leaving the stream running, returns false if not supported.
+        virtual bool Flush() = 0;
+
+        // Devices that return true from SignalsProgress() set the progress event when they free up
+        // a significant amount of buffer space, and when the end of stream has been played out.
+        // The others have to be polled, GetRefillDelay() tells when there will be room again.
+        void SetProgressEvent(HANDLE progressEvent) { m_progressEvent = progressEvent; }
+        virtual bool SignalsProgress() { return false; }
+        virtual REFERENCE_TIME GetRefillDelay() { return OneMillisecond * m_backend->bufferDuration / 4; }
+
+        // Pulling devices call back from their feeding thread to finish the audio right before it's played,
+        // queued chunks have to be in GetQueueFormat() then. Returns false if not supported.
+        using RenderCallback = std::function<void(float* data, size_t frames, uint32_t channels)>;
+        virtual bool SetRenderCallback(RenderCallback) { return false; }
+        virtual DspFormat GetQueueFormat() const { return GetDspFormat(); }
+
+        // Start alignment without blocking, only valid while the device is stopped. The silence becomes
+        // a part of the stream and is played ahead of the queued audio. Returns false if not possible.
+        // Devices that restart their clock for it update the position, the way RenewInactive() does.
+        virtual bool InsertLeadSilence(size_t frames, int64_t& position) { return false; }
+
         SharedString GetId()           const { return m_backend->id; }
         SharedString GetAdapterName()  const { return m_backend->adapterName; }
         SharedString GetEndpointName() const { return m_backend->endpointName; }
@@ -67,9 +97,17 @@ namespace SaneAudioRenderer
         DspFormat        GetDspFormat()      const { return m_backend->dspFormat; }
         uint32_t         GetBufferDuration() const { return m_backend->bufferDuration; }
         REFERENCE_TIME   GetStreamLatency()  const { return m_backend->deviceLatency; }
+        REFERENCE_TIME   GetDevicePeriod()   const { return m_backend->devicePeriod; }
 
         bool IsExclusive() const { return m_backend->exclusive; }
         bool IsRealtime()  const { return m_backend->realtime; }
+        bool IsBitstream() const { return m_backend->bitstream; }
+        bool IsHeadless()  const { return m_backend->headless; }
+
+        bool PlaysPauseSilence() const { return m_backend->pauseSilence; }
+        bool IsBufferAdaptive()  const { return m_backend->adaptiveBuffer; }
+        bool IsLowLatency()      const { return m_backend->lowLatencyPeriod != 0 && m_backend->eventMode; }
+        uint32_t GetLowLatencyPeriod() const { return m_backend->lowLatencyPeriod; }
 
         bool IgnoredSystemChannelMixer() const { return m_backend->ignoredSystemChannelMixer; }
 
@@ -80,6 +118,13 @@ namespace SaneAudioRenderer
 
         std::shared_ptr<AudioDeviceBackend> m_backend;
 
+        void SignalProgress()
+        {
+            HANDLE progressEvent = m_progressEvent;
+            if (progressEvent)
+                SetEvent(progressEvent);
+        }
+
         template <class T>
         bool IsLastInstance(T& smartPointer)
         {
@@ -108,5 +153,9 @@ namespace SaneAudioRenderer
 
             return true;
         }
+
+    private:
+
+        std::atomic<HANDLE> m_progressEvent = nullptr;
     };
 }
@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "AudioDeviceCache.h"
+
+namespace SaneAudioRenderer
+{
+    bool AudioDeviceCache::GetFormatSupport(const std::wstring& id, AUDCLNT_SHAREMODE mode,
+                                            const WAVEFORMATEX& format, HRESULT& result)
+    {
+        CAutoLock objectLock(this);
+
+        auto entry = m_entries.find(id);
+
+        if (entry == m_entries.end())
+            return false;
+
+        auto found = entry->second.formatSupport.find(MakeKey(format, mode));
+
+        if (found == entry->second.formatSupport.end())
+            return false;
+
+        result = found->second;
+        return true;
+    }
+
+    void AudioDeviceCache::SetFormatSupport(const std::wstring& id, AUDCLNT_SHAREMODE mode,
+                                            const WAVEFORMATEX& format, HRESULT result)
+    {
+        CAutoLock objectLock(this);
+
+        try
+        {
+            m_entries[id].formatSupport[MakeKey(format, mode)] = result;
+        }
+        catch (std::bad_alloc&)
+        {
+        }
+    }
+
+    bool AudioDeviceCache::GetDevicePeriod(const std::wstring& id, REFERENCE_TIME& defaultPeriod,
+                                           REFERENCE_TIME& minimumPeriod)
+    {
+        CAutoLock objectLock(this);
+
+        auto entry = m_entries.find(id);
+
+        if (entry == m_entries.end() || !entry->second.hasDevicePeriod)
+            return false;
+
+        defaultPeriod = entry->second.defaultPeriod;
+        minimumPeriod = entry->second.minimumPeriod;
+        return true;
+    }
+
+    void AudioDeviceCache::SetDevicePeriod(const std::wstring& id, REFERENCE_TIME defaultPeriod,
+                                           REFERENCE_TIME minimumPeriod)
+    {
+        CAutoLock objectLock(this);
+
+        try
+        {
+            Entry& entry = m_entries[id];
+            entry.hasDevicePeriod = true;
+            entry.defaultPeriod = defaultPeriod;
+            entry.minimumPeriod = minimumPeriod;
+        }
+        catch (std::bad_alloc&)
+        {
+        }
+    }
+
+    bool AudioDeviceCache::GetAlignedPeriod(const std::wstring& id, const WAVEFORMATEX& format,
+                                            REFERENCE_TIME period, REFERENCE_TIME& alignedPeriod)
+    {
+        CAutoLock objectLock(this);
+
+        auto entry = m_entries.find(id);
+
+        if (entry == m_entries.end())
+            return false;
+
+        auto found = entry->second.alignedPeriods.find(MakeKey(format, period));
+
+        if (found == entry->second.alignedPeriods.end())
+            return false;
+
+        alignedPeriod = found->second;
+        return true;
+    }
+
+    void AudioDeviceCache::SetAlignedPeriod(const std::wstring& id, const WAVEFORMATEX& format,
+                                            REFERENCE_TIME period, REFERENCE_TIME alignedPeriod)
+    {
+        CAutoLock objectLock(this);
+
+        try
+        {
+            m_entries[id].alignedPeriods[MakeKey(format, period)] = alignedPeriod;
+        }
+        catch (std::bad_alloc&)
+        {
+        }
+    }
+
+    void AudioDeviceCache::Invalidate(LPCWSTR id)
+    {
+        CAutoLock objectLock(this);
+
+        try
+        {
+            if (id)
+                m_entries.erase(id);
+        }
+        catch (std::bad_alloc&)
+        {
+            m_entries.clear();
+        }
+    }
+
+    AudioDeviceCache::Key AudioDeviceCache::MakeKey(const WAVEFORMATEX& format, int64_t extra)
+    {
+        return Key(std::string((const char*)&format, sizeof(WAVEFORMATEX) + format.cbSize), extra);
+    }
+}
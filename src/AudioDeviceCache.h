@@ -0,0 +1,49 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // Remembers what endpoints told us during format negotiation, so reopening
+    // the same endpoint doesn't have to probe it all over again.
+    // Entries are dropped when the endpoint reports any change.
+    class AudioDeviceCache final
+        : private CCritSec
+    {
+    public:
+
+        AudioDeviceCache() = default;
+        AudioDeviceCache(const AudioDeviceCache&) = delete;
+        AudioDeviceCache& operator=(const AudioDeviceCache&) = delete;
+
+        bool GetFormatSupport(const std::wstring& id, AUDCLNT_SHAREMODE mode, const WAVEFORMATEX& format,
+                              HRESULT& result);
+        void SetFormatSupport(const std::wstring& id, AUDCLNT_SHAREMODE mode, const WAVEFORMATEX& format,
+                              HRESULT result);
+
+        bool GetDevicePeriod(const std::wstring& id, REFERENCE_TIME& defaultPeriod, REFERENCE_TIME& minimumPeriod);
+        void SetDevicePeriod(const std::wstring& id, REFERENCE_TIME defaultPeriod, REFERENCE_TIME minimumPeriod);
+
+        bool GetAlignedPeriod(const std::wstring& id, const WAVEFORMATEX& format, REFERENCE_TIME period,
+                              REFERENCE_TIME& alignedPeriod);
+        void SetAlignedPeriod(const std::wstring& id, const WAVEFORMATEX& format, REFERENCE_TIME period,
+                              REFERENCE_TIME alignedPeriod);
+
+        void Invalidate(LPCWSTR id);
+
+    private:
+
+        typedef std::pair<std::string, int64_t> Key;
+
+        struct Entry
+        {
+            std::map<Key, HRESULT> formatSupport;
+            std::map<Key, REFERENCE_TIME> alignedPeriods;
+            bool hasDevicePeriod = false;
+            REFERENCE_TIME defaultPeriod = 0;
+            REFERENCE_TIME minimumPeriod = 0;
+        };
+
+        static Key MakeKey(const WAVEFORMATEX& format, int64_t extra);
+
+        std::map<std::wstring, Entry> m_entries;
+    };
+}
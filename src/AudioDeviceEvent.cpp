@@ -10,6 +10,38 @@ namespace SaneAudioRenderer
 
         WinapiFunc<decltype(AvRevertMmThreadCharacteristics)>
         AvRevertMmThreadCharacteristicsFunction(L"avrt.dll", "AvRevertMmThreadCharacteristics");
+
+    #ifndef NDEBUG
+        // Catches heap use from the event thread while it's feeding the device.
+        __declspec(thread) bool RealtimeSection = false;
+
+        std::atomic<int> RealtimeAllocHookUsers = 0;
+        _CRT_ALLOC_HOOK PreviousAllocHook = nullptr;
+
+        int __cdecl RealtimeAllocHook(int allocType, void* userData, size_t size, int blockType,
+                                      long requestNumber, const unsigned char* filename, int lineNumber)
+        {
+            if (RealtimeSection)
+            {
+                // Assertion machinery is allowed to allocate.
+                RealtimeSection = false;
+                assert(!"heap used from real-time thread");
+            }
+
+            return PreviousAllocHook ? PreviousAllocHook(allocType, userData, size, blockType,
+                                                         requestNumber, filename, lineNumber) : TRUE;
+        }
+
+        class RealtimeSectionScope final
+        {
+        public:
+
+            RealtimeSectionScope() { RealtimeSection = true; }
+            RealtimeSectionScope(const RealtimeSectionScope&) = delete;
+            RealtimeSectionScope& operator=(const RealtimeSectionScope&) = delete;
+            ~RealtimeSectionScope() { RealtimeSection = false; }
+        };
+    #endif
     }
 
     AudioDeviceEvent::AudioDeviceEvent(std::shared_ptr<AudioDeviceBackend> backend)
@@ -28,6 +60,26 @@ namespace SaneAudioRenderer
 
         ThrowIfFailed(backend->audioClient->SetEventHandle(m_wake));
 
+    #ifndef NDEBUG
+        if (RealtimeAllocHookUsers++ == 0)
+            PreviousAllocHook = _CrtSetAllocHook(RealtimeAllocHook);
+    #endif
+
+        {
+            // Queue capacity matches the targeted buffer duration plus one device period.
+            // Low latency profile keeps just a couple of periods queued instead.
+            const size_t targetFrames = (backend->exclusive && backend->lowLatencyPeriod != 0) ?
+                                            2 * backend->deviceBufferSize :
+                                            (size_t)llMulDiv(backend->bufferDuration,
+                                                             backend->waveFormat->nSamplesPerSec, 1000, 0);
+
+            m_buffer.Initialize(targetFrames + backend->deviceBufferSize,
+                                backend->waveFormat->wBitsPerSample / 8 * backend->waveFormat->nChannels);
+
+            // Adaptive buffer starts safe and works its way down.
+            m_bufferTarget = m_buffer.GetCapacity();
+        }
+
         m_thread = std::thread(std::bind(&AudioDeviceEvent::EventFeed, this));
     }
 
@@ -41,6 +93,11 @@ namespace SaneAudioRenderer
         if (m_thread.joinable())
             m_thread.join();
 
+    #ifndef NDEBUG
+        if (--RealtimeAllocHookUsers == 0)
+            _CrtSetAllocHook(PreviousAllocHook);
+    #endif
+
         assert(CheckLastInstances());
         m_backend = nullptr;
     }
@@ -52,6 +109,10 @@ namespace SaneAudioRenderer
         if (m_error)
             throw E_FAIL;
 
+        ReportFeed();
+
+        AdaptBuffer();
+
         PushChunkToBuffer(chunk);
 
         if (pFilledEvent && !chunk.IsEmpty())
@@ -65,6 +126,8 @@ namespace SaneAudioRenderer
 
         if (!m_endOfStream)
         {
+            ReportFeed();
+
             DebugOut(ClassName(this), "finish");
             m_endOfStream = true;
             m_endOfStreamPos = GetEnd();
@@ -87,7 +150,9 @@ namespace SaneAudioRenderer
         ThrowIfFailed(m_backend->audioClock->GetFrequency(&deviceClockFrequency));
         ThrowIfFailed(m_backend->audioClock->GetPosition(&deviceClockPosition, nullptr));
 
-        return m_renewPosition + llMulDiv(deviceClockPosition, OneSecond, deviceClockFrequency, 0);
+        // Silence played during pause is not a part of the stream.
+        return m_renewPosition + llMulDiv(deviceClockPosition, OneSecond, deviceClockFrequency, 0) -
+               FramesToTimeLong(m_pauseSilenceFrames, GetRate());
     }
 
     int64_t AudioDeviceEvent::GetEnd()
@@ -102,21 +167,40 @@ namespace SaneAudioRenderer
 
     void AudioDeviceEvent::Start()
     {
+        CAutoLock threadLock(&m_threadMutex);
+
+        m_observeInactivity = false;
+
+        bool resume = false;
         bool delegateStart = false;
 
         {
-            CAutoLock threadLock(&m_threadMutex);
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
 
-            m_observeInactivity = false;
+            m_lastWakeCounter = 0;
 
-            if (m_sentFrames == 0)
+            if (m_pauseSilenceActive)
+            {
+                // The stream never stopped, just switch the event thread back to queued audio.
+                m_pauseSilenceActive = false;
+                resume = true;
+            }
+            else if (m_sentFrames == 0)
             {
                 m_queuedStart = true;
                 delegateStart = true;
             }
+            else
+            {
+                m_streaming = true;
+            }
         }
 
-        if (delegateStart)
+        if (resume)
+        {
+            DebugOut(ClassName(this), "resume");
+        }
+        else if (delegateStart)
         {
             DebugOut(ClassName(this), "queue start");
             m_wake.Set();
@@ -132,24 +216,41 @@ namespace SaneAudioRenderer
     {
         DebugOut(ClassName(this), "stop");
 
+        CAutoLock threadLock(&m_threadMutex);
+        CAutoLock renewLock(&m_renewMutex);
+
+        bool pauseSilence = false;
+
         {
-            CAutoLock threadLock(&m_threadMutex);
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
 
             m_queuedStart = false;
+            m_lastWakeCounter = 0;
+
+            if (!m_awaitingRenew && m_backend->pauseSilence && !m_backend->bitstream && m_sentFrames > 0)
+            {
+                m_pauseSilenceActive = true;
+                pauseSilence = true;
+            }
+        }
 
-            CAutoLock renewLock(&m_renewMutex);
+        if (m_awaitingRenew)
+            return;
 
-            if (m_awaitingRenew)
-                return;
+        if (pauseSilence)
+        {
+            DebugOut(ClassName(this), "playing silence while paused");
+            return;
+        }
 
-            m_backend->audioClient->Stop();
+        m_backend->audioClient->Stop();
+        StopFeeding();
 
-            if (m_backend->exclusive && !m_backend->bitstream)
-            {
-                m_observeInactivity = true;
-                m_activityPointCounter = GetPerformanceCounter();
-                m_observeInactivityWake.Set();
-            }
+        if (m_backend->exclusive && !m_backend->bitstream)
+        {
+            m_observeInactivity = true;
+            m_activityPointCounter = GetPerformanceCounter();
+            m_observeInactivityWake.Set();
         }
     }
 
@@ -157,37 +258,148 @@ namespace SaneAudioRenderer
     {
         DebugOut(ClassName(this), "reset");
 
+        CAutoLock threadLock(&m_threadMutex);
+        CAutoLock renewLock(&m_renewMutex);
+
+        // Only the control side changes it, and we hold the thread mutex.
+        const bool restartPauseSilence = m_pauseSilenceActive && !m_awaitingRenew;
+
+        if (!m_awaitingRenew)
         {
-            CAutoLock threadLock(&m_threadMutex);
+            // Stream has to be stopped for reset, we'll restart the silence right after.
+            if (restartPauseSilence)
+                m_backend->audioClient->Stop();
+
+            StopFeeding();
 
-            CAutoLock renewLock(&m_renewMutex);
+            m_backend->audioClient->Reset();
+        }
 
-            if (!m_awaitingRenew)
-                m_backend->audioClient->Reset();
+        m_renewPosition = 0;
+        m_renewSilenceFrames = 0;
 
-            m_renewPosition = 0;
-            m_renewSilenceFrames = 0;
+        {
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
 
             m_endOfStream = false;
             m_endOfStreamPos = 0;
+            m_endOfStreamSignalled = false;
 
             m_receivedFrames = 0;
             m_sentFrames = 0;
             m_silenceFrames = 0;
+            m_pauseSilenceFrames = 0;
+            m_contendedSilenceFrames = 0;
 
-            {
-                CAutoLock bufferLock(&m_bufferMutex);
-                m_bufferFrames = 0;
-                m_buffer.clear();
-            }
+            m_buffer.Reset();
+            m_skipFrames = 0;
+            m_leadSilenceFrames = 0;
+            m_flushed = false;
+
+            m_lastWakeCounter = 0;
+
+            m_queuedStart = restartPauseSilence;
+        }
+
+        // Stream starts over from an empty queue, let the adaptive buffer work its way down again.
+        // Until then the renderer can't push more than the queue holds before the start.
+        m_bufferTarget = m_buffer.GetCapacity();
+        m_maxWakeInterval = 0;
+        m_windowWakeInterval = 0;
+        m_adaptCounter = 0;
+
+        if (m_observeInactivity)
+            m_activityPointCounter = GetPerformanceCounter();
+
+        if (restartPauseSilence)
+            m_wake.Set();
+    }
+
+    bool AudioDeviceEvent::Flush()
+    {
+        CAutoLock threadLock(&m_threadMutex);
+        CAutoLock renewLock(&m_renewMutex);
+
+        if (m_awaitingRenew)
+            return false;
 
-            if (m_observeInactivity)
-                m_activityPointCounter = GetPerformanceCounter();
+        const uint64_t renewFrames = llMulDiv(m_renewPosition, GetRate(), OneSecond, 0);
+
+        {
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
+
+            if (m_sentFrames == 0)
+                return false;
+
+            m_endOfStream = false;
+            m_endOfStreamPos = 0;
+            m_endOfStreamSignalled = false;
+
+            // Event thread is the only consumer, it discards queued audio on its next wake.
+            m_skipFrames = m_buffer.GetReadable();
+
+            // Move the end of stream to the device write position, event thread will keep it there
+            // by feeding silence until new audio arrives.
+            m_receivedFrames = m_sentFrames - m_pauseSilenceFrames + m_leadSilenceFrames + renewFrames;
+            m_flushed = true;
         }
+
+        DebugOut(ClassName(this), "flush");
+
+        return true;
+    }
+
+    bool AudioDeviceEvent::SetRenderCallback(RenderCallback callback)
+    {
+        CAutoLock threadLock(&m_threadMutex);
+
+        assert(callback);
+
+        // Dithered formats are finished on the producer side.
+        if (m_backend->bitstream || m_backend->dspFormat == DspFormat::Pcm16 || m_receivedFrames > 0)
+            return false;
+
+        {
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
+
+            if (m_sentFrames > 0)
+                return false;
+        }
+
+        // Event thread doesn't touch the queue before Start(), which can't happen while we hold the thread mutex.
+
+        const uint32_t channels = m_backend->waveFormat->nChannels;
+
+        m_buffer.Initialize(m_buffer.GetCapacity(), sizeof(float) * channels);
+        m_pullBuffer.resize(m_backend->deviceBufferSize * channels);
+
+        m_renderCallback = std::move(callback);
+        m_pull = true;
+
+        DebugOut(ClassName(this), "pulling");
+
+        return true;
+    }
+
+    bool AudioDeviceEvent::InsertLeadSilence(size_t frames, int64_t& position)
+    {
+        CAutoLock threadLock(&m_threadMutex);
+        std::lock_guard<RealtimeLock> feedLock(m_feedLock);
+
+        // Paused stream that keeps playing silence takes it too, ahead of the queued audio.
+        if (m_streaming && !m_pauseSilenceActive)
+            return false;
+
+        // Event thread plays it ahead of the queue, sample-accurately.
+        m_leadSilenceFrames += frames;
+        m_receivedFrames += frames;
+
+        return true;
     }
 
     bool AudioDeviceEvent::RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position)
     {
+        // Event thread leaves the backend alone until the next Start(), no need for the feed lock.
         CAutoLock threadLock(&m_threadMutex);
 
         m_observeInactivity = false;
@@ -211,15 +423,9 @@ namespace SaneAudioRenderer
             {
                 DebugOut(ClassName(this), m_renewSilenceFrames, "frames of silence before renew");
 
-                DspChunk chunk = DspChunk(m_backend->dspFormat, m_backend->waveFormat->nChannels,
-                                          m_renewSilenceFrames, m_backend->waveFormat->nSamplesPerSec);
-
-                ZeroMemory(chunk.GetData(), chunk.GetSize());
-
                 {
-                    CAutoLock bufferLock(&m_bufferMutex);
-                    m_buffer.emplace_front(std::move(chunk));
-                    m_bufferFrames += m_renewSilenceFrames;
+                    std::lock_guard<RealtimeLock> feedLock(m_feedLock);
+                    m_leadSilenceFrames = m_renewSilenceFrames;
                 }
 
                 m_renewPosition -= FramesToTime(m_renewSilenceFrames, GetRate());
@@ -255,20 +461,41 @@ namespace SaneAudioRenderer
             {
                 case WAIT_OBJECT_0:
                 {
-                    CAutoLock threadLock(&m_threadMutex);
+                    // Real-time section, no heap use, no waiting on locks and no logging past this point.
+                #ifndef NDEBUG
+                    RealtimeSectionScope realtimeSection;
+                #endif
 
-                    assert(m_sentFrames > 0 || m_queuedStart);
+                    std::unique_lock<RealtimeLock> feedLock(m_feedLock, std::try_to_lock);
+
+                    if (!feedLock.owns_lock())
+                    {
+                        // Device state is being changed. Stale buffer contents would be played again
+                        // in exclusive mode, so don't leave the device without fresh data.
+                        m_skippedWakes++;
+                        PushContendedSilenceToDevice();
+                        break;
+                    }
+
+                    if (!m_streaming && !m_queuedStart)
+                        break;
+
+                    MeasureWake();
 
                     try
                     {
+                        const size_t readableBefore = m_buffer.GetReadable();
+
                         PushBufferToDevice();
 
                         if (m_queuedStart)
                         {
-                            DebugOut(ClassName(this), "start");
                             m_backend->audioClient->Start();
                             m_queuedStart = false;
+                            m_streaming = true;
                         }
+
+                        SignalFeedProgress(readableBefore);
                     }
                     catch (HRESULT)
                     {
@@ -281,6 +508,7 @@ namespace SaneAudioRenderer
                 case WAIT_OBJECT_0 + 1:
                 case WAIT_TIMEOUT:
                 {
+                    // Stream is stopped when we get here, so regular locking and deallocation are fine.
                     CAutoLock threadLock(&m_threadMutex);
 
                     waitTime = INFINITE;
@@ -300,8 +528,12 @@ namespace SaneAudioRenderer
 
                             DebugOut(ClassName(this), "awaiting renew");
 
+                            m_buffer.Skip(m_skipFrames);
+                            m_skipFrames = 0;
+
                             int64_t currentPosition = GetPosition();
-                            m_renewPosition = FramesToTimeLong(m_receivedFrames - m_bufferFrames, GetRate());
+                            m_renewPosition = FramesToTimeLong(m_receivedFrames - m_buffer.GetReadable() - m_leadSilenceFrames,
+                                                              GetRate());
 
                             try
                             {
@@ -341,8 +573,86 @@ namespace SaneAudioRenderer
             AvRevertMmThreadCharacteristicsFunction(taskHandle);
     }
 
+    void AudioDeviceEvent::StopFeeding()
+    {
+        {
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
+            m_queuedStart = false;
+            m_streaming = false;
+        }
+
+        // Contended feed may be writing silence without the lock, wait it out.
+        while (m_contendedFeed)
+            std::this_thread::yield();
+    }
+
+    void AudioDeviceEvent::PushContendedSilenceToDevice()
+    {
+        m_contendedFeed = true;
+
+        if (m_streaming)
+        {
+            try
+            {
+                UINT32 deviceFrames = m_backend->deviceBufferSize;
+
+                if (!m_backend->exclusive)
+                {
+                    // Shared mode buffer only needs topping up to a single period.
+                    UINT32 bufferPadding;
+                    ThrowIfFailed(m_backend->audioClient->GetCurrentPadding(&bufferPadding));
+
+                    const UINT32 periodFrames = std::min(deviceFrames,
+                                                         (UINT32)TimeToFrames(m_backend->devicePeriod, GetRate()));
+
+                    deviceFrames = (bufferPadding < periodFrames) ? periodFrames - bufferPadding : 0;
+                }
+
+                if (deviceFrames > 0)
+                {
+                    BYTE* deviceBuffer;
+                    ThrowIfFailed(m_backend->audioRenderClient->GetBuffer(deviceFrames, &deviceBuffer));
+                    ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, AUDCLNT_BUFFERFLAGS_SILENT));
+
+                    m_contendedSilenceFrames += deviceFrames;
+                }
+            }
+            catch (HRESULT)
+            {
+                // Regular feed will run into it again if it's persistent.
+            }
+        }
+
+        m_contendedFeed = false;
+    }
+
     void AudioDeviceEvent::PushBufferToDevice()
     {
+        // Catch up on what happened while the feed lock was taken by the control side.
+        if (m_skipFrames > 0)
+        {
+            m_buffer.Skip(m_skipFrames);
+            m_skipFrames = 0;
+        }
+
+        if (const uint64_t contendedFrames = m_contendedSilenceFrames.exchange(0))
+        {
+            m_sentFrames += contendedFrames;
+
+            if (m_pauseSilenceActive)
+            {
+                m_pauseSilenceFrames += contendedFrames;
+            }
+            else if (m_flushed)
+            {
+                m_receivedFrames += contendedFrames;
+            }
+            else
+            {
+                m_silenceFrames += contendedFrames;
+            }
+        }
+
         UINT32 deviceFrames = m_backend->deviceBufferSize;
 
         if (!m_backend->exclusive)
@@ -355,11 +665,22 @@ namespace SaneAudioRenderer
         if (deviceFrames == 0)
             return;
 
-        CAutoLock bufferLock(&m_bufferMutex);
+        if (m_pauseSilenceActive)
+        {
+            // Queued audio waits for resume.
+            BYTE* deviceBuffer;
+            ThrowIfFailed(m_backend->audioRenderClient->GetBuffer(deviceFrames, &deviceBuffer));
+            ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, AUDCLNT_BUFFERFLAGS_SILENT));
+
+            m_pauseSilenceFrames += deviceFrames;
+            m_sentFrames += deviceFrames;
+            return;
+        }
 
-        if (deviceFrames > m_bufferFrames && !m_endOfStream && !m_backend->realtime)
+        if (deviceFrames > m_leadSilenceFrames + m_buffer.GetReadable() &&
+            !m_endOfStream && !m_flushed && !m_backend->realtime)
         {
-            DebugOut(ClassName(this), "buffer underrun");
+            m_underruns++;
             return;
         }
 
@@ -368,55 +689,112 @@ namespace SaneAudioRenderer
 
         const size_t frameSize = m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels;
 
-        for (UINT32 doneFrames = 0;;)
+        UINT32 doneFrames = 0;
+
+        if (m_leadSilenceFrames > 0)
         {
-            if (m_buffer.empty())
-            {
-                assert(m_endOfStream || m_backend->realtime);
-                UINT32 doFrames = deviceFrames - doneFrames;
+            UINT32 doFrames = (UINT32)std::min<size_t>(deviceFrames, m_leadSilenceFrames);
+            ZeroMemory(deviceBuffer, doFrames * frameSize);
+            doneFrames += doFrames;
+            m_leadSilenceFrames -= doFrames;
+        }
 
-                if (doneFrames == 0)
-                {
-                    ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, AUDCLNT_BUFFERFLAGS_SILENT));
-                }
-                else
-                {
-                    ZeroMemory(deviceBuffer + doneFrames * frameSize, doFrames * frameSize);
-                    ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, 0));
-                }
+        if (m_pull)
+        {
+            doneFrames += PullBufferToDevice(deviceBuffer + doneFrames * frameSize, deviceFrames - doneFrames);
+        }
+        else
+        {
+            // Copy queued audio straight to the device buffer.
+            doneFrames += (UINT32)m_buffer.Read((char*)deviceBuffer + doneFrames * frameSize, deviceFrames - doneFrames);
+        }
 
-                DebugOut(ClassName(this), "silence", doFrames * 1000. / m_backend->waveFormat->nSamplesPerSec, "ms");
+        if (doneFrames < deviceFrames)
+        {
+            assert(m_endOfStream || m_flushed || m_backend->realtime);
+            UINT32 doFrames = deviceFrames - doneFrames;
 
-                m_silenceFrames += doFrames;
+            if (doneFrames == 0)
+            {
+                ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, AUDCLNT_BUFFERFLAGS_SILENT));
+            }
+            else
+            {
+                ZeroMemory(deviceBuffer + doneFrames * frameSize, doFrames * frameSize);
+                ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, 0));
+            }
 
-                break;
+            if (m_flushed)
+            {
+                m_receivedFrames += doFrames;
             }
             else
             {
-                DspChunk& chunk = m_buffer.front();
-                UINT32 doFrames = std::min(deviceFrames - doneFrames, (UINT32)chunk.GetFrameCount());
-                assert(chunk.GetFrameSize() == frameSize);
-                memcpy(deviceBuffer + doneFrames * frameSize, chunk.GetData(), doFrames * frameSize);
+                m_silenceFrames += doFrames;
+            }
+        }
+        else
+        {
+            ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, 0));
+        }
 
-                doneFrames += doFrames;
-                m_bufferFrames -= doFrames;
+        m_sentFrames += deviceFrames;
+    }
 
-                if (deviceFrames == doneFrames)
-                {
-                    ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(deviceFrames, 0));
+    UINT32 AudioDeviceEvent::PullBufferToDevice(BYTE* deviceBuffer, UINT32 frames)
+    {
+        assert(m_pull);
 
-                    chunk.ShrinkHead(chunk.GetFrameCount() - doFrames);
-                    if (chunk.IsEmpty())
-                        m_buffer.pop_front();
+        const uint32_t channels = m_backend->waveFormat->nChannels;
+        const size_t pullFrames = m_pullBuffer.size() / channels;
+        const size_t frameSize = m_backend->waveFormat->wBitsPerSample / 8 * channels;
 
-                    break;
-                }
+        UINT32 doneFrames = 0;
 
-                m_buffer.pop_front();
-            }
+        while (doneFrames < frames)
+        {
+            const size_t doFrames = m_buffer.Read((char*)m_pullBuffer.data(),
+                                                  std::min<size_t>(frames - doneFrames, pullFrames));
+            if (doFrames == 0)
+                break;
+
+            // Last processing stages run here, right before the audio goes to the device.
+            m_renderCallback(m_pullBuffer.data(), doFrames, channels);
+
+            DspChunk::ConvertBuffer(DspFormat::Float, (const char*)m_pullBuffer.data(), m_backend->dspFormat,
+                                    (char*)deviceBuffer + doneFrames * frameSize, doFrames * channels);
+
+            doneFrames += (UINT32)doFrames;
         }
 
-        m_sentFrames += deviceFrames;
+        return doneFrames;
+    }
+
+    void AudioDeviceEvent::SignalFeedProgress(size_t readableBefore)
+    {
+        // Wake the producer once a quarter of the queue is free again, not on every device period.
+        const size_t threshold = m_bufferTarget / 4 * 3;
+        if (readableBefore > threshold && m_buffer.GetReadable() <= threshold)
+            SignalProgress();
+
+        // And once the device has played everything out after Finish().
+        if (m_endOfStream && !m_endOfStreamSignalled &&
+            m_leadSilenceFrames == 0 && m_buffer.GetReadable() == 0)
+        {
+            // Renew state can't change while we hold the feed lock, so no need for GetPosition() locking.
+            UINT64 deviceClockFrequency, deviceClockPosition;
+            ThrowIfFailed(m_backend->audioClock->GetFrequency(&deviceClockFrequency));
+            ThrowIfFailed(m_backend->audioClock->GetPosition(&deviceClockPosition, nullptr));
+
+            const int64_t position = m_renewPosition - FramesToTimeLong(m_pauseSilenceFrames, GetRate()) +
+                                     llMulDiv(deviceClockPosition, OneSecond, deviceClockFrequency, 0);
+
+            if (position >= m_endOfStreamPos)
+            {
+                m_endOfStreamSignalled = true;
+                SignalProgress();
+            }
+        }
     }
 
     void AudioDeviceEvent::PushChunkToBuffer(DspChunk& chunk)
@@ -424,31 +802,120 @@ namespace SaneAudioRenderer
         if (chunk.IsEmpty())
             return;
 
-        try
+        assert(chunk.GetFrameSize() == m_buffer.GetFrameSize());
+
+        if (m_flushed)
+        {
+            // Event thread extends the end with silence while flushed, it has to stop
+            // doing so before we start counting received frames again.
+            std::lock_guard<RealtimeLock> feedLock(m_feedLock);
+            m_flushed = false;
+        }
+
+        const size_t readable = m_buffer.GetReadable();
+        const size_t target = m_bufferTarget;
+        const size_t doFrames = (target > readable) ?
+                                m_buffer.Write(chunk.GetData(), std::min(chunk.GetFrameCount(), target - readable)) : 0;
+
+        assert(doFrames <= chunk.GetFrameCount());
+        chunk.ShrinkHead(chunk.GetFrameCount() - doFrames);
+
+        m_receivedFrames += doFrames;
+    }
+
+    void AudioDeviceEvent::MeasureWake()
+    {
+        // Longest gap between device events tells how late this thread can be scheduled.
+        const int64_t counter = GetPerformanceCounter();
+
+        if (m_lastWakeCounter != 0)
+        {
+            const int64_t interval = counter - m_lastWakeCounter;
+
+            int64_t maxInterval = m_maxWakeInterval;
+            while (interval > maxInterval && !m_maxWakeInterval.compare_exchange_weak(maxInterval, interval));
+        }
+
+        m_lastWakeCounter = counter;
+    }
+
+    void AudioDeviceEvent::AdaptBuffer()
+    {
+        if (!m_backend->adaptiveBuffer || m_backend->realtime)
+            return;
+
+        const int64_t frequency = GetPerformanceFrequency();
+        const int64_t counter = GetPerformanceCounter();
+
+        if (m_adaptCounter == 0)
+        {
+            m_adaptCounter = counter;
+            return;
+        }
+
+        m_windowWakeInterval = std::max(m_windowWakeInterval, m_maxWakeInterval.exchange(0));
+
+        const uint32_t underruns = m_underruns;
+        const size_t capacity = m_buffer.GetCapacity();
+        const size_t target = m_bufferTarget;
+
+        if (underruns != m_adaptedUnderruns)
         {
-            // Don't deny the allocator its right to reuse
-            // IMediaSample while the chunk is hanging in the buffer.
-            chunk.FreeMediaSample();
+            // Grow fast.
+            m_adaptedUnderruns = underruns;
+            m_adaptCounter = counter;
+
+            const size_t newTarget = std::min(capacity, target + std::max(target / 2, (size_t)m_backend->deviceBufferSize));
 
-            size_t targetFrames = (size_t)llMulDiv(m_backend->bufferDuration,
-                                                   m_backend->waveFormat->nSamplesPerSec, 1000, 0);
+            if (newTarget != target)
+            {
+                DebugOut(ClassName(this), "growing buffer to", newTarget * 1000. / GetRate(), "ms");
+                m_bufferTarget = newTarget;
+            }
+        }
+        else if (counter - m_adaptCounter > frequency * 5)
+        {
+            // Shrink slowly, while keeping enough headroom for the worst wake up seen recently.
+            m_adaptCounter = counter;
 
-            CAutoLock bufferLock(&m_bufferMutex);
+            const size_t intervalFrames = (size_t)llMulDiv(m_windowWakeInterval, GetRate(), frequency, 0);
+            m_windowWakeInterval = 0;
 
-            if (m_bufferFrames > targetFrames)
-                return;
+            const size_t minTarget = std::min(capacity, m_backend->deviceBufferSize + 2 * intervalFrames);
+            const size_t newTarget = std::max(minTarget, target - target / 8);
 
-            size_t chunkFrames = chunk.GetFrameCount();
+            if (newTarget != target)
+            {
+                DebugOut(ClassName(this), "shrinking buffer to", newTarget * 1000. / GetRate(), "ms");
+                m_bufferTarget = newTarget;
+            }
+        }
+    }
 
-            m_bufferFrames += chunkFrames;
-            m_buffer.emplace_back(std::move(chunk));
+    void AudioDeviceEvent::ReportFeed()
+    {
+    #ifndef NDEBUG
+        const uint32_t underruns = m_underruns;
+        if (underruns != m_reportedUnderruns)
+        {
+            DebugOut(ClassName(this), underruns - m_reportedUnderruns, "buffer underruns");
+            m_reportedUnderruns = underruns;
+        }
 
-            m_receivedFrames += chunkFrames;
+        const uint32_t skippedWakes = m_skippedWakes;
+        if (skippedWakes != m_reportedSkippedWakes)
+        {
+            DebugOut(ClassName(this), skippedWakes - m_reportedSkippedWakes, "contended wakes fed with silence");
+            m_reportedSkippedWakes = skippedWakes;
         }
-        catch (std::bad_alloc&)
+
+        const uint64_t silenceFrames = m_silenceFrames;
+        if (silenceFrames > m_reportedSilenceFrames)
         {
-            m_error = true;
-            throw E_OUTOFMEMORY;
+            DebugOut(ClassName(this), "silence", (silenceFrames - m_reportedSilenceFrames) * 1000. /
+                                                 m_backend->waveFormat->nSamplesPerSec, "ms");
         }
+        m_reportedSilenceFrames = silenceFrames;
+    #endif
     }
 }
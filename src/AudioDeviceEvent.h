@@ -1,68 +1,125 @@
-#pragma once
-
-#include "AudioDevice.h"
-#include "DspChunk.h"
-#include "DspFormat.h"
-
-namespace SaneAudioRenderer
-{
-    class AudioDeviceEvent final
-        : public AudioDevice
-    {
-    public:
-
-        AudioDeviceEvent(std::shared_ptr<AudioDeviceBackend> backend);
-        AudioDeviceEvent(const AudioDeviceEvent&) = delete;
-        AudioDeviceEvent& operator=(const AudioDeviceEvent&) = delete;
-        ~AudioDeviceEvent();
-
-        void Push(DspChunk& chunk, CAMEvent* pFilledEvent) override;
-        REFERENCE_TIME Finish(CAMEvent* pFilledEvent) override;
-
-        int64_t GetPosition() override;
-        int64_t GetEnd() override;
-        int64_t GetSilence() override;
-
-        void Start() override;
-        void Stop() override;
-        void Reset() override;
-
-        bool RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position) override;
-
-    private:
-
-        void EventFeed();
-
-        void PushBufferToDevice();
-        void PushChunkToBuffer(DspChunk& chunk);
-
-        std::atomic<bool> m_endOfStream = false;
-        int64_t m_endOfStreamPos = 0;
-
-        std::thread m_thread;
-        CCritSec m_threadMutex;
-
-        CAMEvent m_wake;
-        std::atomic<bool> m_exit = false;
-        std::atomic<bool> m_error = false;
-
-        uint64_t m_sentFrames = 0;
-        std::atomic<uint64_t> m_receivedFrames = 0;
-        std::atomic<uint64_t> m_silenceFrames = 0;
-
-        CCritSec m_bufferMutex;
-        std::deque<DspChunk> m_buffer;
-        size_t m_bufferFrames = 0;
-
-        bool m_queuedStart = false;
-
-        bool m_observeInactivity = false;
-        CAMEvent m_observeInactivityWake;
-        int64_t m_activityPointCounter = 0;
-
-        CCritSec m_renewMutex;
-        bool m_awaitingRenew = false;
-        int64_t m_renewPosition = 0;
-        size_t m_renewSilenceFrames = 0;
-    };
-}
+#pragma once
+
+#include "AudioDevice.h"
+#include "DspChunk.h"
+#include "DspFormat.h"
+#include "RingBuffer.h"
+
+namespace SaneAudioRenderer
+{
+    class AudioDeviceEvent final
+        : public AudioDevice
+    {
+    public:
+
+        AudioDeviceEvent(std::shared_ptr<AudioDeviceBackend> backend);
+        AudioDeviceEvent(const AudioDeviceEvent&) = delete;
+        AudioDeviceEvent& operator=(const AudioDeviceEvent&) = delete;
+        ~AudioDeviceEvent();
+
+        void Push(DspChunk& chunk, CAMEvent* pFilledEvent) override;
+        REFERENCE_TIME Finish(CAMEvent* pFilledEvent) override;
+
+        int64_t GetPosition() override;
+        int64_t GetEnd() override;
+        int64_t GetSilence() override;
+
+        void Start() override;
+        void Stop() override;
+        void Reset() override;
+        bool Flush() override;
+
+        bool RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position) override;
+
+        bool SignalsProgress() override { return true; }
+
+        bool SetRenderCallback(RenderCallback callback) override;
+        DspFormat GetQueueFormat() const override { return m_pull ? DspFormat::Float : GetDspFormat(); }
+
+        bool InsertLeadSilence(size_t frames, int64_t& position) override;
+
+    private:
+
+        void EventFeed();
+
+        void SignalFeedProgress(size_t readableBefore);
+        void MeasureWake();
+
+        void AdaptBuffer();
+
+        void StopFeeding();
+        void PushContendedSilenceToDevice();
+
+        void PushBufferToDevice();
+        UINT32 PullBufferToDevice(BYTE* deviceBuffer, UINT32 frames);
+        void PushChunkToBuffer(DspChunk& chunk);
+
+        void ReportFeed();
+
+        std::atomic<bool> m_endOfStream = false;
+        int64_t m_endOfStreamPos = 0;
+        bool m_endOfStreamSignalled = false;
+
+        std::thread m_thread;
+        CCritSec m_threadMutex;
+
+        // Guards the state event thread touches while feeding the device, taken after m_threadMutex
+        // and m_renewMutex. Held for a few plain stores only, no logging or device calls under it.
+        RealtimeLock m_feedLock;
+
+        // Event thread feeds the device only while the stream runs or is about to start.
+        std::atomic<bool> m_streaming = false;
+
+        // Silence written when the feed lock was contended, accounted on the next regular feed.
+        std::atomic<bool> m_contendedFeed = false;
+        std::atomic<uint64_t> m_contendedSilenceFrames = 0;
+
+        CAMEvent m_wake;
+        std::atomic<bool> m_exit = false;
+        std::atomic<bool> m_error = false;
+
+        uint64_t m_sentFrames = 0;
+        std::atomic<uint64_t> m_receivedFrames = 0;
+        std::atomic<uint64_t> m_silenceFrames = 0;
+
+        // Event thread doesn't log, these are reported from the outside.
+        std::atomic<uint32_t> m_underruns = 0;
+        std::atomic<uint32_t> m_skippedWakes = 0;
+        uint32_t m_reportedUnderruns = 0;
+        uint32_t m_reportedSkippedWakes = 0;
+        uint64_t m_reportedSilenceFrames = 0;
+
+        // Adaptive buffer, event thread measures and the producer acts on it.
+        int64_t m_lastWakeCounter = 0;
+        std::atomic<int64_t> m_maxWakeInterval = 0;
+        int64_t m_windowWakeInterval = 0;
+        int64_t m_adaptCounter = 0;
+        uint32_t m_adaptedUnderruns = 0;
+
+        RingBuffer m_buffer;
+        std::atomic<size_t> m_bufferTarget = 0;
+        size_t m_skipFrames = 0;
+        size_t m_leadSilenceFrames = 0;
+        std::atomic<bool> m_flushed = false;
+
+        // Pull mode, queue holds float audio that is finished by the callback on the event thread.
+        bool m_pull = false;
+        RenderCallback m_renderCallback;
+        std::vector<float> m_pullBuffer;
+
+        bool m_queuedStart = false;
+
+        // Exclusive stream keeps running on silence while paused, if requested.
+        bool m_pauseSilenceActive = false;
+        std::atomic<uint64_t> m_pauseSilenceFrames = 0;
+
+        bool m_observeInactivity = false;
+        CAMEvent m_observeInactivityWake;
+        int64_t m_activityPointCounter = 0;
+
+        CCritSec m_renewMutex;
+        bool m_awaitingRenew = false;
+        int64_t m_renewPosition = 0;
+        size_t m_renewSilenceFrames = 0;
+    };
+}
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "AudioDeviceFile.h"
+
+namespace SaneAudioRenderer
+{
+    AudioDeviceFile::AudioDeviceFile(std::shared_ptr<AudioDeviceBackend> backend, uint32_t speedPercent,
+                                     LPCWSTR pFilePath)
+        : AudioDeviceNull(backend, speedPercent)
+    {
+        assert(pFilePath);
+
+        m_file = CreateFile(pFilePath, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (m_file == INVALID_HANDLE_VALUE)
+            throw HRESULT_FROM_WIN32(GetLastError());
+
+        // Scratch space for copying one device buffer worth of frames from the queue.
+        m_scratch.resize(m_backend->deviceBufferSize *
+                         m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels);
+
+        m_formatSize = sizeof(WAVEFORMATEX) + m_backend->waveFormat->cbSize;
+
+        try
+        {
+            WriteHeader();
+        }
+        catch (HRESULT)
+        {
+            CloseHandle(m_file);
+            throw;
+        }
+    }
+
+    AudioDeviceFile::~AudioDeviceFile()
+    {
+        try
+        {
+            WriteHeader();
+        }
+        catch (HRESULT)
+        {
+            DebugOut(ClassName(this), "failed to finalize wav header");
+        }
+
+        CloseHandle(m_file);
+    }
+
+    void AudioDeviceFile::Stop()
+    {
+        AudioDeviceNull::Stop();
+
+        // Keep the file playable while it's still being written.
+        try
+        {
+            WriteHeader();
+        }
+        catch (HRESULT ex)
+        {
+            SetError(ex);
+        }
+    }
+
+    void AudioDeviceFile::Play(RingBuffer& buffer, size_t frames)
+    {
+        const size_t frameSize = buffer.GetFrameSize();
+        const size_t scratchFrames = m_scratch.size() / frameSize;
+        assert(scratchFrames > 0);
+
+        while (frames > 0)
+        {
+            const size_t doFrames = buffer.Read(m_scratch.data(), std::min(frames, scratchFrames));
+            assert(doFrames > 0);
+
+            Write(m_scratch.data(), doFrames * frameSize);
+            frames -= doFrames;
+        }
+    }
+
+    void AudioDeviceFile::PlaySilence(size_t frames)
+    {
+        const size_t frameSize = m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels;
+        const size_t scratchFrames = m_scratch.size() / frameSize;
+
+        ZeroMemory(m_scratch.data(), m_scratch.size());
+
+        while (frames > 0)
+        {
+            const size_t doFrames = std::min(frames, scratchFrames);
+
+            Write(m_scratch.data(), doFrames * frameSize);
+            frames -= doFrames;
+        }
+    }
+
+    void AudioDeviceFile::Write(const void* pData, size_t size)
+    {
+        DWORD written;
+        if (!WriteFile(m_file, pData, (DWORD)size, &written, nullptr) || written != size)
+            throw HRESULT_FROM_WIN32(GetLastError());
+
+        m_dataSize += size;
+    }
+
+    void AudioDeviceFile::WriteHeader()
+    {
+        // Riff sizes are 32-bit, anything past 4GB is still written but won't be declared.
+        const uint32_t dataSize = (uint32_t)std::min<uint64_t>(m_dataSize, UINT32_MAX - 36 - m_formatSize);
+        const uint32_t riffSize = 4 + 8 + m_formatSize + 8 + dataSize;
+
+        LARGE_INTEGER current, zero = {};
+        if (!SetFilePointerEx(m_file, zero, &current, FILE_CURRENT) ||
+            !SetFilePointerEx(m_file, zero, nullptr, FILE_BEGIN))
+        {
+            throw HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        const uint64_t dataSizeBefore = m_dataSize;
+
+        Write("RIFF", 4);
+        Write(&riffSize, 4);
+        Write("WAVE", 4);
+        Write("fmt ", 4);
+        Write(&m_formatSize, 4);
+        Write(&(*m_backend->waveFormat), m_formatSize);
+        Write("data", 4);
+        Write(&dataSize, 4);
+
+        m_dataSize = dataSizeBefore;
+
+        if (current.QuadPart > 0 && !SetFilePointerEx(m_file, current, nullptr, FILE_BEGIN))
+            throw HRESULT_FROM_WIN32(GetLastError());
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "AudioDeviceNull.h"
+
+namespace SaneAudioRenderer
+{
+    // Headless device, plays audio into a wav file.
+    class AudioDeviceFile final
+        : public AudioDeviceNull
+    {
+    public:
+
+        AudioDeviceFile(std::shared_ptr<AudioDeviceBackend> backend, uint32_t speedPercent, LPCWSTR pFilePath);
+        AudioDeviceFile(const AudioDeviceFile&) = delete;
+        AudioDeviceFile& operator=(const AudioDeviceFile&) = delete;
+        ~AudioDeviceFile();
+
+        void Stop() override;
+
+    protected:
+
+        void Play(RingBuffer& buffer, size_t frames) override;
+        void PlaySilence(size_t frames) override;
+
+    private:
+
+        void Write(const void* pData, size_t size);
+        void WriteHeader();
+
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+
+        std::vector<char> m_scratch;
+
+        uint32_t m_formatSize = 0;
+        uint64_t m_dataSize = 0;
+    };
+}
@@ -2,8 +2,11 @@
 #include "AudioDeviceManager.h"
 
 #include "AudioDeviceEvent.h"
+#include "AudioDeviceFile.h"
+#include "AudioDeviceNull.h"
 #include "AudioDevicePush.h"
 #include "DspMatrix.h"
+#include "SimulatedAudioClient.h"
 
 namespace SaneAudioRenderer
 {
@@ -49,6 +52,24 @@ namespace SaneAudioRenderer
             });
         }
 
+        std::vector<uint32_t> GetSameFamilyRates(uint32_t rate)
+        {
+            // Rates related to the given one by power of two ratio, in the order they should be tried.
+            // Upsampling loses nothing, so all higher rates come before any lower one. Within each
+            // direction the closest ratio comes first. For 44.1kHz it's 88.2, 176.4, 352.8kHz,
+            // and for 192kHz it's 384, 96, 48kHz.
+            // Resampling between them is cheaper and cleaner than across rate families.
+            std::vector<uint32_t> rates;
+
+            for (uint32_t r = rate * 2; r <= 384000; r *= 2)
+                rates.push_back(r);
+
+            for (uint32_t r = rate; r % 2 == 0 && r / 2 >= 32000; r /= 2)
+                rates.push_back(r / 2);
+
+            return rates;
+        }
+
         UINT32 GetDevicePropertyUint(IPropertyStore* pStore, REFPROPERTYKEY key)
         {
             assert(pStore);
@@ -83,10 +104,66 @@ namespace SaneAudioRenderer
                            SPEAKER_SIDE_LEFT | SPEAKER_SIDE_RIGHT);
         }
 
+        bool UseCache(const AudioDeviceBackend& backend)
+        {
+            // Simulated endpoint has no id and can be reconfigured at will.
+            return !backend.simulation && backend.id && !backend.id->empty();
+        }
+
+        HRESULT CheckFormatSupport(AudioDeviceCache& cache, const AudioDeviceBackend& backend,
+                                   AUDCLNT_SHAREMODE mode, const WAVEFORMATEX& format)
+        {
+            assert(backend.audioClient);
+
+            HRESULT result;
+
+            if (UseCache(backend) && cache.GetFormatSupport(*backend.id, mode, format, result))
+                return result;
+
+            WAVEFORMATEX* pClosest = nullptr;
+            result = backend.audioClient->IsFormatSupported(mode, &format,
+                                                            (mode == AUDCLNT_SHAREMODE_SHARED) ? &pClosest : nullptr);
+            CoTaskMemFree(pClosest);
+
+            // Don't remember transient failures.
+            if (UseCache(backend) && (SUCCEEDED(result) || result == AUDCLNT_E_UNSUPPORTED_FORMAT))
+                cache.SetFormatSupport(*backend.id, mode, format, result);
+
+            return result;
+        }
+
+        void CreateSimulatedAudioClient(AudioDeviceBackend& backend)
+        {
+            assert(backend.simulation);
+
+            backend.id = std::make_shared<std::wstring>();
+            backend.adapterName = std::make_shared<std::wstring>(L"Headless");
+            backend.endpointName = std::make_shared<std::wstring>(L"Simulated");
+            backend.endpointFormFactor = UnknownFormFactor;
+            backend.supportsSharedEventMode = true;
+            backend.supportsExclusiveEventMode = true;
+
+            auto pClient = new SimulatedAudioClient(*backend.simulation);
+
+            pClient->NonDelegatingAddRef();
+
+            HRESULT result = pClient->NonDelegatingQueryInterface(IID_PPV_ARGS(&backend.audioClient));
+
+            pClient->NonDelegatingRelease();
+
+            ThrowIfFailed(result);
+        }
+
         void CreateAudioClient(IMMDeviceEnumerator* pEnumerator, AudioDeviceBackend& backend)
         {
             assert(pEnumerator);
 
+            if (backend.simulation)
+            {
+                CreateSimulatedAudioClient(backend);
+                return;
+            }
+
             IMMDevicePtr device;
 
             if (!backend.id || backend.id->empty())
@@ -146,7 +223,8 @@ namespace SaneAudioRenderer
                                            CLSCTX_INPROC_SERVER, nullptr, (void**)&backend.audioClient));
         }
 
-        HRESULT CheckBitstreamFormat(IMMDeviceEnumerator* pEnumerator, SharedWaveFormat format, ISettings* pSettings)
+        HRESULT CheckBitstreamFormat(IMMDeviceEnumerator* pEnumerator, AudioDeviceCache& cache,
+                                     SharedWaveFormat format, ISettings2* pSettings)
         {
             assert(pEnumerator);
             assert(format);
@@ -169,7 +247,7 @@ namespace SaneAudioRenderer
                 if (!device.audioClient)
                     return E_FAIL;
 
-                return device.audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &(*format), nullptr);
+                return CheckFormatSupport(cache, device, AUDCLNT_SHAREMODE_EXCLUSIVE, *format);
             }
             catch (HRESULT ex)
             {
@@ -177,8 +255,8 @@ namespace SaneAudioRenderer
             }
         }
 
-        HRESULT CreateAudioDeviceBackend(IMMDeviceEnumerator* pEnumerator,
-                                         SharedWaveFormat format, bool realtime, ISettings* pSettings,
+        HRESULT CreateAudioDeviceBackend(IMMDeviceEnumerator* pEnumerator, AudioDeviceCache& cache,
+                                         SharedWaveFormat format, bool realtime, ISettings2* pSettings,
                                          std::shared_ptr<AudioDeviceBackend>& backend)
         {
             assert(pEnumerator);
@@ -202,6 +280,23 @@ namespace SaneAudioRenderer
                     backend->bufferDuration = buffer;
                 }
 
+                {
+                    UINT32 headlessDevice;
+                    ThrowIfFailed(pSettings->GetHeadlessDevice(&headlessDevice, nullptr, nullptr));
+
+                    if (headlessDevice == ISettings2::HEADLESS_DEVICE_SIMULATED)
+                    {
+                        UINT32 period, positionJitter, eventJitter;
+                        INT32 drift;
+                        pSettings->GetSimulatedDeviceSettings(&period, &drift, &positionJitter, &eventJitter);
+
+                        // Microseconds to reference time.
+                        SimulatedAudioParameters simulation = {period * 10, drift, positionJitter * 10, eventJitter * 10};
+                        backend->simulation = std::make_shared<SimulatedAudioParameters>(simulation);
+                        backend->headless = true;
+                    }
+                }
+
                 CreateAudioClient(pEnumerator, *backend);
 
                 if (!backend->audioClient)
@@ -238,9 +333,14 @@ namespace SaneAudioRenderer
                     // Exclusive.
                     std::vector<WAVEFORMATEXTENSIBLE> priorities;
 
+                    // Try to avoid resampling, or at least resample by integer ratio, before settling on mix rate.
+                    const auto familyRates = GetSameFamilyRates(inputRate);
+
                     if (backend->endpointFormFactor == DigitalAudioDisplayDevice)
                     {
                         AppendPcmFormatPack(priorities, inputRate, inputChannels, inputMask);
+                        for (const auto rate : familyRates)
+                            AppendPcmFormatPack(priorities, rate, inputChannels, inputMask);
                         AppendPcmFormatPack(priorities, mixRate, inputChannels, inputMask);
 
                         // Shift between 5.1 with side channels and 5.1 with back channels.
@@ -254,6 +354,8 @@ namespace SaneAudioRenderer
                     }
 
                     AppendPcmFormatPack(priorities, inputRate, mixChannels, mixMask);
+                    for (const auto rate : familyRates)
+                        AppendPcmFormatPack(priorities, rate, mixChannels, mixMask);
                     AppendPcmFormatPack(priorities, mixRate, mixChannels, mixMask);
 
                     priorities.insert(priorities.cend(), {
@@ -265,8 +367,7 @@ namespace SaneAudioRenderer
                     {
                         assert(DspFormatFromWaveFormat(f.Format) != DspFormat::Unknown);
 
-                        if (SUCCEEDED(backend->audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE,
-                                                                              &f.Format, nullptr)))
+                        if (SUCCEEDED(CheckFormatSupport(cache, *backend, AUDCLNT_SHAREMODE_EXCLUSIVE, f.Format)))
                         {
                             backend->dspFormat = DspFormatFromWaveFormat(f.Format);
                             backend->waveFormat = CopyWaveFormat(f.Format);
@@ -308,15 +409,11 @@ namespace SaneAudioRenderer
                     {
                         assert(DspFormatFromWaveFormat(f.Format) != DspFormat::Unknown);
 
-                        WAVEFORMATEX* pClosest;
-                        if (SUCCEEDED(backend->audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED,
-                                                                              &f.Format, &pClosest)))
+                        HRESULT supported = CheckFormatSupport(cache, *backend, AUDCLNT_SHAREMODE_SHARED, f.Format);
+                        if (SUCCEEDED(supported))
                         {
-                            if (pClosest)
-                            {
-                                CoTaskMemFree(pClosest);
-                            }
-                            else
+                            // S_FALSE means the closest match was suggested instead.
+                            if (supported == S_OK)
                             {
                                 bool usingSystemChannelMixer = f.Format.nChannels != mixChannels ||
                                                                f.dwChannelMask != mixMask;
@@ -346,6 +443,21 @@ namespace SaneAudioRenderer
                 backend->eventMode = (realtime && backend->supportsSharedEventMode) ||
                                      (backend->exclusive && backend->supportsExclusiveEventMode);
 
+                // Keeping exclusive stream running through pause spares us renewing it on resume,
+                // and some hdmi receivers don't like the signal going away either. Event mode devices only.
+                backend->pauseSilence = backend->exclusive && !backend->bitstream &&
+                                        pSettings->GetExclusivePauseSilence();
+
+                // Buffer duration setting becomes the upper bound, event mode devices only.
+                backend->adaptiveBuffer = !realtime && !!pSettings->GetAdaptiveBuffer();
+
+                // Explicit period, exclusive event mode devices only.
+                backend->lowLatencyPeriod = (backend->exclusive && !backend->bitstream) ?
+                                                pSettings->GetLowLatencyPeriod() : 0;
+
+                // Comes from the cache when possible, and is used again once the client is initialized.
+                REFERENCE_TIME defaultPeriod;
+
                 {
                     AUDCLNT_SHAREMODE mode = backend->exclusive ? AUDCLNT_SHAREMODE_EXCLUSIVE :
                                                                   AUDCLNT_SHAREMODE_SHARED;
@@ -354,14 +466,31 @@ namespace SaneAudioRenderer
                     if (backend->eventMode)
                         flags |= AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
 
-                    REFERENCE_TIME defaultPeriod;
                     REFERENCE_TIME minimumPeriod;
-                    ThrowIfFailed(backend->audioClient->GetDevicePeriod(&defaultPeriod, &minimumPeriod));
+                    if (!UseCache(*backend) || !cache.GetDevicePeriod(*backend->id, defaultPeriod, minimumPeriod))
+                    {
+                        ThrowIfFailed(backend->audioClient->GetDevicePeriod(&defaultPeriod, &minimumPeriod));
+
+                        if (UseCache(*backend))
+                            cache.SetDevicePeriod(*backend->id, defaultPeriod, minimumPeriod);
+                    }
 
                     REFERENCE_TIME bufferDuration = OneMillisecond * backend->bufferDuration;
                     if (backend->eventMode)
                         bufferDuration = realtime ? minimumPeriod : defaultPeriod;
 
+                    if (backend->exclusive && backend->eventMode && backend->lowLatencyPeriod != 0)
+                        bufferDuration = std::max<REFERENCE_TIME>(minimumPeriod, backend->lowLatencyPeriod * 10);
+
+                    const REFERENCE_TIME requestedBufferDuration = bufferDuration;
+
+                    // Skip straight to the aligned periodicity if we've been here before.
+                    if (backend->exclusive && backend->eventMode && UseCache(*backend))
+                    {
+                        cache.GetAlignedPeriod(*backend->id, *backend->waveFormat,
+                                               requestedBufferDuration, bufferDuration);
+                    }
+
                     REFERENCE_TIME periodicy = 0;
                     if (backend->exclusive && backend->eventMode)
                         periodicy = bufferDuration;
@@ -390,8 +519,18 @@ namespace SaneAudioRenderer
                         // Initialize our audio client again with the right periodicity.
                         result = backend->audioClient->Initialize(mode, flags, bufferDuration,
                                                                   periodicy, &(*backend->waveFormat), nullptr);
+
+                        if (SUCCEEDED(result) && UseCache(*backend))
+                        {
+                            cache.SetAlignedPeriod(*backend->id, *backend->waveFormat,
+                                                   requestedBufferDuration, bufferDuration);
+                        }
                     }
 
+                    // Whatever we remembered about the endpoint may be wrong now.
+                    if (FAILED(result) && UseCache(*backend))
+                        cache.Invalidate(backend->id->c_str());
+
                     ThrowIfFailed(result);
                 }
 
@@ -401,6 +540,11 @@ namespace SaneAudioRenderer
                 ThrowIfFailed(backend->audioClient->GetStreamLatency(&backend->deviceLatency));
                 ThrowIfFailed(backend->audioClient->GetBufferSize(&backend->deviceBufferSize));
 
+                // Exclusive event mode buffer is exactly one period long.
+                backend->devicePeriod = (backend->exclusive && backend->eventMode) ?
+                                            FramesToTime(backend->deviceBufferSize, backend->waveFormat->nSamplesPerSec) :
+                                            defaultPeriod;
+
                 return S_OK;
             }
             catch (std::bad_alloc&)
@@ -462,6 +606,56 @@ namespace SaneAudioRenderer
             return S_OK;
         }
 
+        std::shared_ptr<AudioDeviceBackend> CreateHeadlessDeviceBackend(SharedWaveFormat format, bool realtime,
+                                                                        ISettings2* pSettings, LPCWSTR endpointName)
+        {
+            assert(format);
+            assert(pSettings);
+
+            auto backend = std::make_shared<AudioDeviceBackend>();
+
+            UINT32 buffer;
+            ThrowIfFailed(pSettings->GetOuputDevice(nullptr, nullptr, &buffer));
+
+            backend->id = std::make_shared<std::wstring>();
+            backend->adapterName = std::make_shared<std::wstring>(L"Headless");
+            backend->endpointName = std::make_shared<std::wstring>(endpointName);
+            backend->endpointFormFactor = UnknownFormFactor;
+
+            backend->bitstream = (DspFormatFromWaveFormat(*format) == DspFormat::Unknown);
+
+            if (backend->bitstream)
+            {
+                backend->dspFormat = DspFormat::Unknown;
+                backend->waveFormat = format;
+            }
+            else
+            {
+                // Nothing to negotiate with, take the input as float.
+                backend->dspFormat = DspFormat::Float;
+                backend->waveFormat = CopyWaveFormat(BuildWaveFormatExt(KSDATAFORMAT_SUBTYPE_IEEE_FLOAT, 32, 32,
+                                                                        format->nSamplesPerSec, format->nChannels,
+                                                                        DspMatrix::GetChannelMask(*format)).Format);
+            }
+
+            backend->mixFormat = backend->waveFormat;
+
+            backend->bufferDuration = buffer;
+            backend->deviceLatency = 0;
+            backend->deviceBufferSize = (UINT32)llMulDiv(buffer, backend->waveFormat->nSamplesPerSec, 1000, 0);
+
+            backend->exclusive = false;
+            backend->eventMode = false;
+            backend->realtime = realtime;
+            backend->headless = true;
+            backend->pauseSilence = false;
+            backend->adaptiveBuffer = false;
+            backend->lowLatencyPeriod = 0;
+            backend->devicePeriod = 0;
+
+            return backend;
+        }
+
         HRESULT GetDefaultDeviceIdInternal(IMMDeviceEnumerator* pEnumerator,
                                            std::unique_ptr<WCHAR, CoTaskMemFreeDeleter>& id)
         {
@@ -487,9 +681,11 @@ namespace SaneAudioRenderer
         }
     }
 
-    AudioDeviceNotificationClient::AudioDeviceNotificationClient(std::atomic<uint32_t>& defaultDeviceSerial)
+    AudioDeviceNotificationClient::AudioDeviceNotificationClient(std::atomic<uint32_t>& defaultDeviceSerial,
+                                                                 AudioDeviceCache& cache)
         : CUnknown("SaneAudioRenderer::AudioDeviceNotificationClient", nullptr)
         , m_defaultDeviceSerial(defaultDeviceSerial)
+        , m_cache(cache)
     {
     }
 
@@ -509,7 +705,30 @@ namespace SaneAudioRenderer
         return S_OK;
     }
 
+    STDMETHODIMP AudioDeviceNotificationClient::OnDeviceStateChanged(LPCWSTR id, DWORD)
+    {
+        m_cache.Invalidate(id);
+
+        return S_OK;
+    }
+
+    STDMETHODIMP AudioDeviceNotificationClient::OnDeviceRemoved(LPCWSTR id)
+    {
+        m_cache.Invalidate(id);
+
+        return S_OK;
+    }
+
+    STDMETHODIMP AudioDeviceNotificationClient::OnPropertyValueChanged(LPCWSTR id, const PROPERTYKEY)
+    {
+        // Mix format, channel configuration, enhancements - any of them can change what the endpoint takes.
+        m_cache.Invalidate(id);
+
+        return S_OK;
+    }
+
     AudioDeviceManager::AudioDeviceManager(HRESULT& result)
+        : m_speculationDone(TRUE/*manual reset*/)
     {
         if (FAILED(result))
             return;
@@ -517,7 +736,9 @@ namespace SaneAudioRenderer
         try
         {
             if (static_cast<HANDLE>(m_wake) == NULL ||
-                static_cast<HANDLE>(m_done) == NULL)
+                static_cast<HANDLE>(m_done) == NULL ||
+                static_cast<HANDLE>(m_speculationDone) == NULL ||
+                static_cast<HANDLE>(m_speculationRelease) == NULL)
             {
                 throw E_OUTOFMEMORY;
             }
@@ -551,7 +772,7 @@ namespace SaneAudioRenderer
             }
 
             {
-                auto pNotificationClient = new AudioDeviceNotificationClient(m_defaultDeviceSerial);
+                auto pNotificationClient = new AudioDeviceNotificationClient(m_defaultDeviceSerial, m_cache);
 
                 pNotificationClient->NonDelegatingAddRef();
 
@@ -574,6 +795,9 @@ namespace SaneAudioRenderer
 
     AudioDeviceManager::~AudioDeviceManager()
     {
+        EndSpeculation();
+        m_speculationBackend = nullptr;
+
         if (m_enumerator && m_notificationClient)
             m_enumerator->UnregisterEndpointNotificationCallback(m_notificationClient);
 
@@ -586,32 +810,99 @@ namespace SaneAudioRenderer
             m_thread.join();
     }
 
-    bool AudioDeviceManager::BitstreamFormatSupported(SharedWaveFormat format, ISettings* pSettings)
+    bool AudioDeviceManager::BitstreamFormatSupported(SharedWaveFormat format, ISettings2* pSettings)
     {
         assert(format);
         assert(pSettings);
 
-        m_function = [&] { return CheckBitstreamFormat(m_enumerator, format, pSettings); };
+        m_function = [&] { return CheckBitstreamFormat(m_enumerator, m_cache, format, pSettings); };
         m_wake.Set();
         m_done.Wait();
 
         return SUCCEEDED(m_result);
     }
 
+    void AudioDeviceManager::CreateDeviceAsync(SharedWaveFormat format, bool realtime, ISettings2* pSettings)
+    {
+        assert(format);
+        assert(pSettings);
+
+        // Only one speculation at a time, the previous one is of no use anymore.
+        EndSpeculation();
+        m_speculationBackend = nullptr;
+
+        {
+            UINT32 headlessDevice;
+            if (SUCCEEDED(pSettings->GetHeadlessDevice(&headlessDevice, nullptr, nullptr)) &&
+                headlessDevice != ISettings2::HEADLESS_DEVICE_NONE &&
+                headlessDevice != ISettings2::HEADLESS_DEVICE_SIMULATED)
+            {
+                // Headless devices are created instantly, nothing to gain here.
+                return;
+            }
+        }
+
+        m_speculationFormat = format;
+        m_speculationRealtime = realtime;
+        m_speculationSettingsSerial = pSettings->GetSerial();
+        m_speculationDefaultDeviceSerial = m_defaultDeviceSerial;
+
+        ISettings2Ptr settings(pSettings);
+
+        m_speculationDone.Reset();
+        m_speculationRelease.Reset();
+
+        try
+        {
+            m_speculationThread = std::thread(std::bind(&AudioDeviceManager::Speculate, this, format, realtime, settings));
+        }
+        catch (std::system_error&)
+        {
+            // The device will be created on demand then.
+            return;
+        }
+
+        m_speculationPending = true;
+
+        DebugOut(ClassName(this), "started speculative device creation");
+    }
+
+    bool AudioDeviceManager::IsDeviceReady()
+    {
+        if (m_speculationPending && m_speculationDone.Check())
+            m_speculationPending = false;
+
+        return !m_speculationPending;
+    }
+
     std::unique_ptr<AudioDevice> AudioDeviceManager::CreateDevice(SharedWaveFormat format, bool realtime,
-                                                                  ISettings* pSettings)
+                                                                  ISettings2* pSettings)
     {
         assert(format);
         assert(pSettings);
 
-        std::shared_ptr<AudioDeviceBackend> backend;
+        std::shared_ptr<AudioDeviceBackend> backend = TakeSpeculation(format, realtime, pSettings);
 
-        m_function = [&] { return CreateAudioDeviceBackend(m_enumerator, format, realtime, pSettings, backend); };
-        m_wake.Set();
-        m_done.Wait();
+        {
+            UINT32 headlessDevice;
+            if (SUCCEEDED(pSettings->GetHeadlessDevice(&headlessDevice, nullptr, nullptr)) &&
+                headlessDevice != ISettings2::HEADLESS_DEVICE_NONE &&
+                headlessDevice != ISettings2::HEADLESS_DEVICE_SIMULATED)
+            {
+                return CreateHeadlessDevice(format, realtime, pSettings);
+            }
+        }
 
-        if (FAILED(m_result))
-            return nullptr;
+        if (!backend)
+        {
+            m_function = [&] { return CreateAudioDeviceBackend(m_enumerator, m_cache, format, realtime,
+                                                                   pSettings, backend); };
+            m_wake.Set();
+            m_done.Wait();
+
+            if (FAILED(m_result))
+                return nullptr;
+        }
 
         try
         {
@@ -630,8 +921,68 @@ namespace SaneAudioRenderer
         }
     }
 
+    std::unique_ptr<AudioDevice> AudioDeviceManager::CreateNullDevice(SharedWaveFormat format, bool realtime,
+                                                                      ISettings2* pSettings)
+    {
+        assert(format);
+        assert(pSettings);
+
+        try
+        {
+            auto backend = CreateHeadlessDeviceBackend(format, realtime, pSettings, L"Null");
+
+            return std::unique_ptr<AudioDevice>(new AudioDeviceNull(backend, ISettings2::HEADLESS_DEVICE_SPEED_REALTIME));
+        }
+        catch (HRESULT)
+        {
+            return nullptr;
+        }
+        catch (std::bad_alloc&)
+        {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<AudioDevice> AudioDeviceManager::CreateHeadlessDevice(SharedWaveFormat format, bool realtime,
+                                                                          ISettings2* pSettings)
+    {
+        assert(format);
+        assert(pSettings);
+
+        try
+        {
+            UINT32 headlessDevice, speed;
+            LPWSTR pFilePath = nullptr;
+            ThrowIfFailed(pSettings->GetHeadlessDevice(&headlessDevice, &pFilePath, &speed));
+            std::unique_ptr<WCHAR, CoTaskMemFreeDeleter> holder(pFilePath);
+
+            if (headlessDevice == ISettings2::HEADLESS_DEVICE_FILE)
+            {
+                auto backend = CreateHeadlessDeviceBackend(format, realtime, pSettings, pFilePath);
+
+                return std::unique_ptr<AudioDevice>(new AudioDeviceFile(backend, speed, pFilePath));
+            }
+
+            assert(headlessDevice == ISettings2::HEADLESS_DEVICE_NULL);
+
+            auto backend = CreateHeadlessDeviceBackend(format, realtime, pSettings, L"Null");
+
+            return std::unique_ptr<AudioDevice>(new AudioDeviceNull(backend, speed));
+        }
+        catch (HRESULT)
+        {
+            return nullptr;
+        }
+        catch (std::bad_alloc&)
+        {
+            return nullptr;
+        }
+    }
+
     bool AudioDeviceManager::RenewInactiveDevice(AudioDevice& device, int64_t& position)
     {
+        JoinSpeculation();
+
         auto renewFunction = [this](std::shared_ptr<AudioDeviceBackend>& backend) -> bool
         {
             m_function = [&] { return RecreateAudioDeviceBackend(m_enumerator, backend); };
@@ -663,4 +1014,85 @@ namespace SaneAudioRenderer
 
         return id;
     }
+
+    void AudioDeviceManager::Speculate(SharedWaveFormat format, bool realtime, ISettings2Ptr settings)
+    {
+        CoInitializeHelper coInitializeHelper(COINIT_MULTITHREADED);
+
+        std::shared_ptr<AudioDeviceBackend> backend;
+        if (FAILED(CreateAudioDeviceBackend(m_enumerator, m_cache, format, realtime, settings, backend)))
+            backend = nullptr;
+
+        const bool exclusive = backend && backend->exclusive;
+
+        {
+            CAutoLock speculationLock(&m_speculationMutex);
+            m_speculationBackend = std::move(backend);
+        }
+
+        m_speculationDone.Set();
+
+        // Exclusive client keeps the endpoint from everyone else, don't hold it long if nobody comes for it.
+        if (exclusive && !m_speculationRelease.Wait(2000))
+        {
+            CAutoLock speculationLock(&m_speculationMutex);
+
+            if (m_speculationBackend)
+            {
+                DebugOut(ClassName(this), "releasing unclaimed speculatively created exclusive device");
+                m_speculationBackend = nullptr;
+            }
+        }
+    }
+
+    void AudioDeviceManager::JoinSpeculation()
+    {
+        if (m_speculationPending)
+        {
+            m_speculationDone.Wait();
+            m_speculationPending = false;
+        }
+    }
+
+    void AudioDeviceManager::EndSpeculation()
+    {
+        if (m_speculationThread.joinable())
+        {
+            m_speculationRelease.Set();
+            m_speculationThread.join();
+        }
+
+        m_speculationPending = false;
+    }
+
+    std::shared_ptr<AudioDeviceBackend> AudioDeviceManager::TakeSpeculation(SharedWaveFormat format, bool realtime,
+                                                                            ISettings2* pSettings)
+    {
+        JoinSpeculation();
+
+        std::shared_ptr<AudioDeviceBackend> backend;
+
+        {
+            CAutoLock speculationLock(&m_speculationMutex);
+            std::swap(backend, m_speculationBackend);
+        }
+
+        EndSpeculation();
+
+        // Exclusive backend must be released before trying to create another one on the same endpoint.
+        if (backend &&
+            (m_speculationRealtime != realtime ||
+             m_speculationSettingsSerial != pSettings->GetSerial() ||
+             m_speculationDefaultDeviceSerial != m_defaultDeviceSerial ||
+             m_speculationFormat->cbSize != format->cbSize ||
+             memcmp(m_speculationFormat.get(), format.get(), sizeof(WAVEFORMATEX) + format->cbSize) != 0))
+        {
+            DebugOut(ClassName(this), "discarding speculatively created device");
+            backend = nullptr;
+        }
+
+        m_speculationFormat = nullptr;
+
+        return backend;
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AudioDevice.h"
+#include "AudioDeviceCache.h"
 #include "Interfaces.h"
 
 namespace SaneAudioRenderer
@@ -13,21 +14,22 @@ namespace SaneAudioRenderer
 
         DECLARE_IUNKNOWN
 
-        AudioDeviceNotificationClient(std::atomic<uint32_t>& defaultDeviceSerial);
+        AudioDeviceNotificationClient(std::atomic<uint32_t>& defaultDeviceSerial, AudioDeviceCache& cache);
         AudioDeviceNotificationClient(const AudioDeviceNotificationClient&) = delete;
         AudioDeviceNotificationClient& operator=(const AudioDeviceNotificationClient&) = delete;
 
         STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
 
-        STDMETHODIMP OnDeviceStateChanged(LPCWSTR, DWORD) override { return S_OK; }
+        STDMETHODIMP OnDeviceStateChanged(LPCWSTR id, DWORD) override;
         STDMETHODIMP OnDeviceAdded(LPCWSTR) override { return S_OK; }
-        STDMETHODIMP OnDeviceRemoved(LPCWSTR) override { return S_OK; }
+        STDMETHODIMP OnDeviceRemoved(LPCWSTR id) override;
         STDMETHODIMP OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR);
-        STDMETHODIMP OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY) override { return S_OK; }
+        STDMETHODIMP OnPropertyValueChanged(LPCWSTR id, const PROPERTYKEY) override;
 
     private:
 
         std::atomic<uint32_t>& m_defaultDeviceSerial;
+        AudioDeviceCache& m_cache;
     };
 
     class AudioDeviceManager final
@@ -39,8 +41,11 @@ namespace SaneAudioRenderer
         AudioDeviceManager& operator=(const AudioDeviceManager&) = delete;
         ~AudioDeviceManager();
 
-        bool BitstreamFormatSupported(SharedWaveFormat format, ISettings* pSettings);
-        std::unique_ptr<AudioDevice> CreateDevice(SharedWaveFormat format, bool realtime, ISettings* pSettings);
+        bool BitstreamFormatSupported(SharedWaveFormat format, ISettings2* pSettings);
+        void CreateDeviceAsync(SharedWaveFormat format, bool realtime, ISettings2* pSettings);
+        bool IsDeviceReady();
+        std::unique_ptr<AudioDevice> CreateDevice(SharedWaveFormat format, bool realtime, ISettings2* pSettings);
+        std::unique_ptr<AudioDevice> CreateNullDevice(SharedWaveFormat format, bool realtime, ISettings2* pSettings);
         bool RenewInactiveDevice(AudioDevice& device, int64_t& position);
 
         uint32_t GetDefaultDeviceSerial() { return m_defaultDeviceSerial; }
@@ -48,6 +53,14 @@ namespace SaneAudioRenderer
 
     private:
 
+        std::unique_ptr<AudioDevice> CreateHeadlessDevice(SharedWaveFormat format, bool realtime, ISettings2* pSettings);
+
+        void Speculate(SharedWaveFormat format, bool realtime, ISettings2Ptr settings);
+        void JoinSpeculation();
+        void EndSpeculation();
+        std::shared_ptr<AudioDeviceBackend> TakeSpeculation(SharedWaveFormat format, bool realtime,
+                                                            ISettings2* pSettings);
+
         std::thread m_thread;
         std::atomic<bool> m_exit = false;
         CAMEvent m_wake;
@@ -58,7 +71,22 @@ namespace SaneAudioRenderer
 
         IMMDeviceEnumeratorPtr m_enumerator;
 
+        AudioDeviceCache m_cache;
+
         IMMNotificationClientPtr m_notificationClient;
         std::atomic<uint32_t> m_defaultDeviceSerial = 0;
+
+        // Backend created in advance by CreateDeviceAsync(), picked up by CreateDevice() if still valid.
+        // It has a thread of its own, so queries don't have to wait for it.
+        std::thread m_speculationThread;
+        CAMEvent m_speculationDone;
+        CAMEvent m_speculationRelease;
+        bool m_speculationPending = false;
+        SharedWaveFormat m_speculationFormat;
+        bool m_speculationRealtime = false;
+        UINT32 m_speculationSettingsSerial = 0;
+        uint32_t m_speculationDefaultDeviceSerial = 0;
+        CCritSec m_speculationMutex;
+        std::shared_ptr<AudioDeviceBackend> m_speculationBackend;
     };
 }
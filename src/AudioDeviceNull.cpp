@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "AudioDeviceNull.h"
+
+namespace SaneAudioRenderer
+{
+    AudioDeviceNull::AudioDeviceNull(std::shared_ptr<AudioDeviceBackend> backend, uint32_t speedPercent)
+    {
+        DebugOut(ClassName(this), "create");
+
+        assert(backend);
+        assert(backend->headless);
+        m_backend = backend;
+
+        m_clock = new SimulatedAudioClock(m_backend->waveFormat->nSamplesPerSec, speedPercent);
+        m_clock->NonDelegatingAddRef();
+        HRESULT result = m_clock->NonDelegatingQueryInterface(IID_PPV_ARGS(&m_backend->audioClock));
+        m_clock->NonDelegatingRelease();
+        ThrowIfFailed(result);
+
+        m_buffer.Initialize(m_backend->deviceBufferSize,
+                            m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels);
+    }
+
+    AudioDeviceNull::~AudioDeviceNull()
+    {
+        DebugOut(ClassName(this), "destroy");
+
+        assert(CheckLastInstances());
+        m_backend = nullptr;
+    }
+
+    void AudioDeviceNull::Push(DspChunk& chunk, CAMEvent* pFilledEvent)
+    {
+        assert(!m_endOfStream);
+
+        if (FAILED(m_error))
+            throw m_error;
+
+        Update();
+
+        while (!chunk.IsEmpty())
+        {
+            assert(chunk.GetFrameSize() == m_buffer.GetFrameSize());
+
+            const size_t doFrames = m_buffer.Write(chunk.GetData(), chunk.GetFrameCount());
+
+            if (doFrames == 0)
+                break;
+
+            chunk.ShrinkHead(chunk.GetFrameCount() - doFrames);
+            m_endFrames += doFrames;
+
+            // Clock of unlimited speed device only moves when there is something to play.
+            if (m_clock->IsFreeRunning())
+                break;
+
+            Update();
+        }
+
+        if (pFilledEvent && !chunk.IsEmpty())
+            pFilledEvent->Set();
+    }
+
+    REFERENCE_TIME AudioDeviceNull::Finish(CAMEvent* pFilledEvent)
+    {
+        if (FAILED(m_error))
+            throw m_error;
+
+        if (!m_endOfStream)
+        {
+            DebugOut(ClassName(this), "finish");
+            m_endOfStream = true;
+            m_endOfStreamPos = GetEnd();
+        }
+
+        if (pFilledEvent)
+            pFilledEvent->Set();
+
+        return m_endOfStreamPos - GetPosition();
+    }
+
+    int64_t AudioDeviceNull::GetPosition()
+    {
+        Update();
+
+        return FramesToTimeLong(m_playedFrames, GetRate());
+    }
+
+    int64_t AudioDeviceNull::GetEnd()
+    {
+        Update();
+
+        return FramesToTimeLong(m_endFrames, GetRate());
+    }
+
+    int64_t AudioDeviceNull::GetSilence()
+    {
+        Update();
+
+        return FramesToTimeLong(m_silenceFrames, GetRate());
+    }
+
+    void AudioDeviceNull::Start()
+    {
+        DebugOut(ClassName(this), "start");
+
+        m_clock->Start();
+        Update();
+    }
+
+    void AudioDeviceNull::Stop()
+    {
+        DebugOut(ClassName(this), "stop");
+
+        Update();
+        m_clock->Stop();
+    }
+
+    void AudioDeviceNull::Reset()
+    {
+        DebugOut(ClassName(this), "reset");
+
+        m_clock->Reset();
+        m_buffer.Reset();
+
+        m_playedFrames = 0;
+        m_endFrames = 0;
+        m_silenceFrames = 0;
+        m_leadSilenceFrames = 0;
+
+        m_endOfStream = false;
+        m_endOfStreamPos = 0;
+    }
+
+    bool AudioDeviceNull::Flush()
+    {
+        return false;
+    }
+
+    bool AudioDeviceNull::InsertLeadSilence(size_t frames, int64_t& position)
+    {
+        m_leadSilenceFrames += frames;
+        m_endFrames += frames;
+
+        return true;
+    }
+
+    bool AudioDeviceNull::RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position)
+    {
+        position = 0;
+        return true;
+    }
+
+    void AudioDeviceNull::Play(RingBuffer& buffer, size_t frames)
+    {
+        buffer.Skip(frames);
+    }
+
+    void AudioDeviceNull::SetError(HRESULT error)
+    {
+        assert(FAILED(error));
+
+        if (SUCCEEDED(m_error))
+        {
+            DebugOut(ClassName(this), "output error", error);
+            m_error = error;
+        }
+    }
+
+    void AudioDeviceNull::PlayBuffer(size_t frames)
+    {
+        const size_t readable = m_buffer.GetReadable();
+
+        if (SUCCEEDED(m_error))
+        {
+            try
+            {
+                Play(m_buffer, frames);
+                return;
+            }
+            catch (HRESULT ex)
+            {
+                SetError(ex);
+            }
+        }
+
+        // Drop what's left, the clock doesn't wait for failed output.
+        m_buffer.Skip(frames - (readable - m_buffer.GetReadable()));
+    }
+
+    void AudioDeviceNull::PlaySilenceFrames(size_t frames)
+    {
+        if (SUCCEEDED(m_error))
+        {
+            try
+            {
+                PlaySilence(frames);
+            }
+            catch (HRESULT ex)
+            {
+                SetError(ex);
+            }
+        }
+    }
+
+    void AudioDeviceNull::Update()
+    {
+        if (!m_clock->IsFreeRunning())
+            m_clock->Advance(m_leadSilenceFrames + m_buffer.GetReadable());
+
+        const uint64_t clockFrames = m_clock->GetFrames();
+        assert(clockFrames >= m_playedFrames);
+
+        size_t doFrames = (size_t)(clockFrames - m_playedFrames);
+
+        if (doFrames == 0)
+            return;
+
+        if (m_leadSilenceFrames > 0)
+        {
+            const size_t leadFrames = std::min(doFrames, m_leadSilenceFrames);
+            PlaySilenceFrames(leadFrames);
+
+            m_leadSilenceFrames -= leadFrames;
+            doFrames -= leadFrames;
+        }
+
+        const size_t bufferFrames = std::min(doFrames, m_buffer.GetReadable());
+        PlayBuffer(bufferFrames);
+
+        // Clock keeps going on buffer underrun, fill the gap with silence.
+        const size_t silenceFrames = doFrames - bufferFrames;
+        if (silenceFrames > 0)
+        {
+            PlaySilenceFrames(silenceFrames);
+
+            m_endFrames += silenceFrames;
+            m_silenceFrames += silenceFrames;
+        }
+
+        m_playedFrames = clockFrames;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "AudioDevice.h"
+#include "DspChunk.h"
+#include "DspFormat.h"
+#include "RingBuffer.h"
+#include "SimulatedAudioClock.h"
+
+namespace SaneAudioRenderer
+{
+    // Headless device, plays audio into nowhere at the pace of its simulated clock.
+    class AudioDeviceNull
+        : public AudioDevice
+    {
+    public:
+
+        AudioDeviceNull(std::shared_ptr<AudioDeviceBackend> backend, uint32_t speedPercent);
+        AudioDeviceNull(const AudioDeviceNull&) = delete;
+        AudioDeviceNull& operator=(const AudioDeviceNull&) = delete;
+        ~AudioDeviceNull();
+
+        void Push(DspChunk& chunk, CAMEvent* pFilledEvent) override;
+        REFERENCE_TIME Finish(CAMEvent* pFilledEvent) override;
+
+        int64_t GetPosition() override;
+        int64_t GetEnd() override;
+        int64_t GetSilence() override;
+
+        void Start() override;
+        void Stop() override;
+        void Reset() override;
+        bool Flush() override;
+
+        bool InsertLeadSilence(size_t frames, int64_t& position) override;
+
+        bool RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position) override;
+
+    protected:
+
+        // Called with the played frames in order, silence included. Failures are latched
+        // and reported from the next Push() or Finish(), so the clock can keep going.
+        virtual void Play(RingBuffer& buffer, size_t frames);
+        virtual void PlaySilence(size_t frames) {}
+
+        void SetError(HRESULT error);
+
+    private:
+
+        void Update();
+
+        void PlayBuffer(size_t frames);
+        void PlaySilenceFrames(size_t frames);
+
+        SimulatedAudioClock* m_clock = nullptr;
+
+        RingBuffer m_buffer;
+
+        uint64_t m_playedFrames = 0;
+        uint64_t m_endFrames = 0;
+        uint64_t m_silenceFrames = 0;
+        size_t m_leadSilenceFrames = 0;
+
+        bool m_endOfStream = false;
+        int64_t m_endOfStreamPos = 0;
+
+        HRESULT m_error = S_OK;
+    };
+}
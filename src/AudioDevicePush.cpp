@@ -13,6 +13,11 @@ namespace SaneAudioRenderer
 
         if (static_cast<HANDLE>(m_wake) == NULL)
             throw E_OUTOFMEMORY;
+
+        const size_t bufferBytes = m_backend->deviceBufferSize *
+                                   m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels;
+        m_history.resize(bufferBytes);
+        m_pendingBuffer.resize(bufferBytes);
     }
 
     AudioDevicePush::~AudioDevicePush()
@@ -74,7 +79,8 @@ namespace SaneAudioRenderer
         ThrowIfFailed(m_backend->audioClock->GetFrequency(&deviceClockFrequency));
         ThrowIfFailed(m_backend->audioClock->GetPosition(&deviceClockPosition, nullptr));
 
-        return llMulDiv(deviceClockPosition, OneSecond, deviceClockFrequency, 0);
+        return FramesToTimeLong(m_restartFrames, GetRate()) +
+               llMulDiv(deviceClockPosition, OneSecond, deviceClockFrequency, 0);
     }
 
     int64_t AudioDevicePush::GetEnd()
@@ -91,6 +97,7 @@ namespace SaneAudioRenderer
     {
         DebugOut(ClassName(this), "start");
 
+        m_running = true;
         m_backend->audioClient->Start();
     }
 
@@ -99,6 +106,7 @@ namespace SaneAudioRenderer
         DebugOut(ClassName(this), "stop");
 
         m_backend->audioClient->Stop();
+        m_running = false;
     }
 
     void AudioDevicePush::Reset()
@@ -117,16 +125,87 @@ namespace SaneAudioRenderer
         m_pushedFrames = 0;
         m_silenceFrames = 0;
 
+        m_running = false;
+        m_historyPosition = 0;
+        m_historyFrames = 0;
+        m_pendingFrames = 0;
+        m_pendingPosition = 0;
+        m_pendingSilenceFrames = 0;
+        m_restartFrames = 0;
+
         m_endOfStream = false;
         m_endOfStreamPos = 0;
     }
 
+    bool AudioDevicePush::Flush()
+    {
+        // Audio is queued in the device buffer directly, and there is no way
+        // to take it back without stopping the stream.
+        return false;
+    }
+
     bool AudioDevicePush::RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position)
     {
-        position = 0;
+        position = FramesToTimeLong(m_restartFrames, GetRate());
         return true;
     }
 
+    bool AudioDevicePush::InsertLeadSilence(size_t frames, int64_t& position)
+    {
+        // Silence feed owns the device buffer after Finish(), and a rebuild still being written
+        // can't be rebuilt again.
+        if (m_running || m_thread.joinable() ||
+            m_pendingSilenceFrames > 0 || m_pendingPosition < m_pendingFrames)
+        {
+            return false;
+        }
+
+        UINT32 bufferPadding;
+        ThrowIfFailed(m_backend->audioClient->GetCurrentPadding(&bufferPadding));
+
+        if (bufferPadding > m_historyFrames)
+            return false;
+
+        // Take what's queued out of the history, it's written back after the silence.
+        const size_t frameSize = m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels;
+        const size_t historyCapacity = m_backend->deviceBufferSize;
+
+        m_historyPosition = (m_historyPosition + historyCapacity - bufferPadding) % historyCapacity;
+        m_historyFrames -= bufferPadding;
+
+        const size_t firstFrames = std::min<size_t>(bufferPadding, historyCapacity - m_historyPosition);
+        memcpy(m_pendingBuffer.data(), m_history.data() + m_historyPosition * frameSize, firstFrames * frameSize);
+        memcpy(m_pendingBuffer.data() + firstFrames * frameSize, m_history.data(), (bufferPadding - firstFrames) * frameSize);
+
+        // Stream is stopped, resetting it loses nothing but the device clock position.
+        ThrowIfFailed(m_backend->audioClient->Reset());
+        m_restartFrames = m_pushedFrames - bufferPadding;
+
+        m_pendingSilenceFrames = frames;
+        m_pendingFrames = bufferPadding;
+        m_pendingPosition = 0;
+
+        m_pushedFrames += frames;
+
+        PushPendingToDevice();
+
+        position = FramesToTimeLong(m_restartFrames, GetRate());
+
+        return true;
+    }
+
+    REFERENCE_TIME AudioDevicePush::GetRefillDelay()
+    {
+        // Push mode devices don't notify us, but we know exactly when a quarter of the buffer frees up.
+        UINT32 bufferPadding;
+        if (FAILED(m_backend->audioClient->GetCurrentPadding(&bufferPadding)))
+            return AudioDevice::GetRefillDelay();
+
+        const UINT32 targetPadding = m_backend->deviceBufferSize / 4 * 3;
+
+        return (bufferPadding > targetPadding) ? FramesToTime(bufferPadding - targetPadding, GetRate()) : 0;
+    }
+
     void AudioDevicePush::SilenceFeed()
     {
         SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
@@ -135,8 +214,10 @@ namespace SaneAudioRenderer
         {
             try
             {
-                m_silenceFrames += PushSilenceToDevice(m_backend->deviceBufferSize);
-                m_wake.Wait(m_backend->bufferDuration / 4);
+                if (PushPendingToDevice())
+                    m_silenceFrames += PushSilenceToDevice(m_backend->deviceBufferSize);
+
+                m_wake.Wait(std::max(1, (int32_t)(GetRefillDelay() / OneMillisecond)));
             }
             catch (HRESULT)
             {
@@ -147,6 +228,15 @@ namespace SaneAudioRenderer
 
     void AudioDevicePush::PushChunkToDevice(DspChunk& chunk, CAMEvent* pFilledEvent)
     {
+        // Rebuilt start goes first, and it fills the buffer up whenever something is left pending.
+        if (!PushPendingToDevice())
+        {
+            if (pFilledEvent)
+                pFilledEvent->Set();
+
+            return;
+        }
+
         // Get up-to-date information on the device buffer.
         UINT32 bufferPadding;
         ThrowIfFailed(m_backend->audioClient->GetCurrentPadding(&bufferPadding));
@@ -164,6 +254,8 @@ namespace SaneAudioRenderer
         memcpy(deviceBuffer, chunk.GetData(), doFrames * chunk.GetFrameSize());
         ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(doFrames, 0));
 
+        RecordHistory(chunk.GetData(), doFrames);
+
         // If the buffer is fully filled, set the corresponding event (if requested).
         if (pFilledEvent &&
             bufferPadding + doFrames == m_backend->deviceBufferSize)
@@ -200,4 +292,76 @@ namespace SaneAudioRenderer
 
         return doFrames;
     }
+
+    bool AudioDevicePush::PushPendingToDevice()
+    {
+        if (m_pendingSilenceFrames == 0 && m_pendingPosition == m_pendingFrames)
+            return true;
+
+        UINT32 bufferPadding;
+        ThrowIfFailed(m_backend->audioClient->GetCurrentPadding(&bufferPadding));
+
+        UINT32 freeFrames = m_backend->deviceBufferSize - bufferPadding;
+
+        if (m_pendingSilenceFrames > 0 && freeFrames > 0)
+        {
+            const UINT32 doFrames = (UINT32)std::min<size_t>(freeFrames, m_pendingSilenceFrames);
+
+            BYTE* deviceBuffer;
+            ThrowIfFailed(m_backend->audioRenderClient->GetBuffer(doFrames, &deviceBuffer));
+            ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(doFrames, AUDCLNT_BUFFERFLAGS_SILENT));
+
+            RecordHistory(nullptr, doFrames);
+
+            m_pendingSilenceFrames -= doFrames;
+            freeFrames -= doFrames;
+        }
+
+        if (m_pendingSilenceFrames == 0 && m_pendingPosition < m_pendingFrames && freeFrames > 0)
+        {
+            const size_t frameSize = m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels;
+            const UINT32 doFrames = (UINT32)std::min<size_t>(freeFrames, m_pendingFrames - m_pendingPosition);
+            const char* data = m_pendingBuffer.data() + m_pendingPosition * frameSize;
+
+            BYTE* deviceBuffer;
+            ThrowIfFailed(m_backend->audioRenderClient->GetBuffer(doFrames, &deviceBuffer));
+            memcpy(deviceBuffer, data, doFrames * frameSize);
+            ThrowIfFailed(m_backend->audioRenderClient->ReleaseBuffer(doFrames, 0));
+
+            RecordHistory(data, doFrames);
+
+            m_pendingPosition += doFrames;
+        }
+
+        return m_pendingSilenceFrames == 0 && m_pendingPosition == m_pendingFrames;
+    }
+
+    void AudioDevicePush::RecordHistory(const char* data, size_t frames)
+    {
+        // Null data stands for silence.
+        const size_t frameSize = m_backend->waveFormat->wBitsPerSample / 8 * m_backend->waveFormat->nChannels;
+        const size_t historyCapacity = m_backend->deviceBufferSize;
+
+        assert(frames <= historyCapacity);
+
+        while (frames > 0)
+        {
+            const size_t doFrames = std::min(frames, historyCapacity - m_historyPosition);
+            char* history = m_history.data() + m_historyPosition * frameSize;
+
+            if (data)
+            {
+                memcpy(history, data, doFrames * frameSize);
+                data += doFrames * frameSize;
+            }
+            else
+            {
+                ZeroMemory(history, doFrames * frameSize);
+            }
+
+            m_historyPosition = (m_historyPosition + doFrames) % historyCapacity;
+            m_historyFrames = std::min(m_historyFrames + doFrames, historyCapacity);
+            frames -= doFrames;
+        }
+    }
 }
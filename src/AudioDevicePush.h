@@ -26,15 +26,22 @@ namespace SaneAudioRenderer
         void Start() override;
         void Stop() override;
         void Reset() override;
+        bool Flush() override;
 
         bool RenewInactive(const RenewBackendFunction& renewBackend, int64_t& position) override;
 
+        REFERENCE_TIME GetRefillDelay() override;
+
+        bool InsertLeadSilence(size_t frames, int64_t& position) override;
+
     private:
 
         void SilenceFeed();
 
         void PushChunkToDevice(DspChunk& chunk, CAMEvent* pFilledEvent);
         UINT32 PushSilenceToDevice(UINT32 frames);
+        bool PushPendingToDevice();
+        void RecordHistory(const char* data, size_t frames);
 
         bool m_endOfStream = false;
         int64_t m_endOfStreamPos = 0;
@@ -46,5 +53,19 @@ namespace SaneAudioRenderer
         CAMEvent m_wake;
         std::atomic<bool> m_exit = false;
         std::atomic<bool> m_error = false;
+
+        // Audio is queued in the endpoint buffer directly. The last buffer worth of it is kept, so that
+        // the buffer of a stopped stream can be rebuilt with lead silence ahead of the queued audio.
+        // What doesn't fit back in right away is pending, and goes to the device before anything else.
+        // The rebuild resets the device clock, stream position where it restarted from is kept.
+        bool m_running = false;
+        std::vector<char> m_history;
+        size_t m_historyPosition = 0;
+        size_t m_historyFrames = 0;
+        std::vector<char> m_pendingBuffer;
+        size_t m_pendingFrames = 0;
+        size_t m_pendingPosition = 0;
+        size_t m_pendingSilenceFrames = 0;
+        uint64_t m_restartFrames = 0;
     };
 }
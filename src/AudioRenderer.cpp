@@ -5,7 +5,7 @@
 
 namespace SaneAudioRenderer
 {
-    AudioRenderer::AudioRenderer(ISettings* pSettings, MyClock& clock, HRESULT& result)
+    AudioRenderer::AudioRenderer(ISettings2* pSettings, MyClock& clock, HRESULT& result)
         : m_deviceManager(result)
         , m_myClock(clock)
         , m_flush(TRUE/*manual reset*/)
@@ -21,7 +21,8 @@ namespace SaneAudioRenderer
             if (!m_settings)
                 throw E_UNEXPECTED;
 
-            if (static_cast<HANDLE>(m_flush) == NULL)
+            if (static_cast<HANDLE>(m_flush) == NULL ||
+                static_cast<HANDLE>(m_deviceProgress) == NULL)
             {
                 throw E_OUTOFMEMORY;
             }
@@ -37,6 +38,9 @@ namespace SaneAudioRenderer
         // Just in case.
         if (m_state != State_Stopped)
             Stop();
+
+        // Pulling device calls back into us until it's gone.
+        ClearDevice();
     }
 
     void AudioRenderer::SetClock(IReferenceClock* pClock)
@@ -77,6 +81,17 @@ namespace SaneAudioRenderer
                 // Clear the device if related settings were changed.
                 CheckDeviceSettings();
 
+                // Switch to the new default device once it's ready.
+                if (m_deviceHandoff && m_deviceManager.IsDeviceReady())
+                    HandOffDevice();
+
+                // Let go of the previous device once it has played out.
+                ReleaseRetiredDevice(false);
+
+                // Give audio hardware another try after the device failed.
+                if (m_deviceFailed)
+                    ClearDevice();
+
                 // Create the device if needed.
                 if (!m_device)
                     CreateDevice();
@@ -107,7 +122,7 @@ namespace SaneAudioRenderer
                 }
 
                 // Apply clock corrections.
-                if (!m_live && m_device && m_state == State_Running)
+                if (!m_live && m_device && m_state == State_Running && !m_deviceFlushed)
                     ApplyClockCorrection();
 
                 // Apply dsp chain.
@@ -120,7 +135,7 @@ namespace SaneAudioRenderer
 
                     EnumerateProcessors(f);
 
-                    DspChunk::ToFormat(m_device->GetDspFormat(), chunk);
+                    DspChunk::ToFormat(m_device->GetQueueFormat(), chunk);
                 }
 
                 if (m_device && !IsBitstreaming() && m_state == State_Running)
@@ -137,6 +152,10 @@ namespace SaneAudioRenderer
                         m_guidedReclockActive = true;
                     }
                 }
+
+                // Resume clock slaving to the device that was flushed without stopping.
+                if (m_device && m_deviceFlushed && m_state == State_Running && !chunk.IsEmpty())
+                    PushFlushedDevice(chunk, pFilledEvent);
             }
             catch (HRESULT)
             {
@@ -177,7 +196,7 @@ namespace SaneAudioRenderer
 
                     EnumerateProcessors(f);
 
-                    DspChunk::ToFormat(m_device->GetDspFormat(), chunk);
+                    DspChunk::ToFormat(m_device->GetQueueFormat(), chunk);
                 }
             }
             catch (std::bad_alloc&)
@@ -189,8 +208,15 @@ namespace SaneAudioRenderer
 
         auto doBlock = [&]
         {
-            // Increase system timer resolution.
-            TimePeriodHelper timePeriodHelper(1);
+            // Devices that don't signal the end of stream are polled, increase system timer resolution for them.
+            std::unique_ptr<TimePeriodHelper> timePeriodHelper;
+
+            {
+                CAutoLock objectLock(this);
+
+                if (m_device && !m_device->SignalsProgress())
+                    timePeriodHelper = std::make_unique<TimePeriodHelper>(1);
+            }
 
             for (;;)
             {
@@ -216,9 +242,12 @@ namespace SaneAudioRenderer
                 if (remaining <= 0)
                     return true;
 
-                // Sleep until predicted end of stream.
-                if (m_flush.Wait(std::max(1, (int32_t)(remaining / OneMillisecond))))
+                // Sleep until the device reports the end of stream, or until predicted end of stream.
+                if (WaitForAny(std::max(1, (int32_t)(remaining / OneMillisecond)),
+                               m_flush, m_deviceProgress) == WAIT_OBJECT_0)
+                {
                     return false;
+                }
             }
         };
 
@@ -235,26 +264,43 @@ namespace SaneAudioRenderer
     {
         CAutoLock objectLock(this);
 
+        ReleaseRetiredDevice(true);
+
         if (m_device)
         {
             if (m_state == State_Running)
             {
                 m_myClock.UnslaveClockFromAudio();
-                m_device->Stop();
-                m_device->Reset();
-                m_dropNextFrames = 0;
-                m_sampleCorrection.NewDeviceBuffer();
-                InitializeProcessors();
-                m_startClockOffset = m_sampleCorrection.GetLastFrameEnd();
-                PushReslavingJitter();
-                StartDevice();
+
+                if (m_device->Flush())
+                {
+                    // The device keeps playing silence, we will re-slave the clock on next Push().
+                    m_deviceFlushed = true;
+                    m_dropNextFrames = 0;
+                    m_sampleCorrection.NewDeviceBuffer();
+                    ResetProcessors();
+                    m_startClockOffset = m_sampleCorrection.GetLastFrameEnd();
+                }
+                else
+                {
+                    m_device->Stop();
+                    m_device->Reset();
+                    m_deviceFlushed = false;
+                    m_dropNextFrames = 0;
+                    m_sampleCorrection.NewDeviceBuffer();
+                    ResetProcessors();
+                    m_startClockOffset = m_sampleCorrection.GetLastFrameEnd();
+                    PushReslavingJitter();
+                    StartDevice();
+                }
             }
             else
             {
                 m_device->Reset();
+                m_deviceFlushed = false;
                 m_dropNextFrames = 0;
                 m_sampleCorrection.NewDeviceBuffer();
-                InitializeProcessors();
+                ResetProcessors();
             }
         }
 
@@ -293,14 +339,32 @@ namespace SaneAudioRenderer
     {
         CAutoLock objectLock(this);
 
+        const bool bitstreaming = (DspFormatFromWaveFormat(*inputFormat) == DspFormat::Unknown);
+
+        // Pcm device can take any pcm input after rematrixing and resampling, no need to reopen it.
+        // Headless devices are cheap to recreate, and may be standing in for a device that failed.
+        const bool keepDevice = m_device && !m_device->IsBitstream() && !m_device->IsHeadless() &&
+                                !bitstreaming && m_live == live;
+
         m_inputFormat = inputFormat;
         m_live = live;
 
         m_sampleCorrection.NewFormat(inputFormat);
 
-        ClearDevice();
+        m_bitstreaming = bitstreaming;
 
-        m_bitstreaming = (DspFormatFromWaveFormat(*inputFormat) == DspFormat::Unknown);
+        if (keepDevice)
+        {
+            DebugOut(ClassName(this), "keeping the device for new input format");
+            InitializeProcessors();
+        }
+        else
+        {
+            ClearDevice();
+
+            // Get the device ready in the background, Push() will pick it up.
+            m_deviceManager.CreateDeviceAsync(m_inputFormat, m_live || m_externalClock, m_settings);
+        }
     }
 
     void AudioRenderer::NewSegment(double rate)
@@ -339,10 +403,19 @@ namespace SaneAudioRenderer
     {
         CAutoLock objectLock(this);
 
+        ReleaseRetiredDevice(true);
+
         if (m_device)
         {
             m_myClock.UnslaveClockFromAudio();
             m_device->Stop();
+
+            if (m_deviceFlushed)
+            {
+                // Nothing was pushed since the flush, start anew.
+                m_device->Reset();
+                m_deviceFlushed = false;
+            }
         }
 
         assert(m_state != State_Paused);
@@ -400,6 +473,81 @@ namespace SaneAudioRenderer
         return m_guidedReclockActive;
     }
 
+    REFERENCE_TIME AudioRenderer::GetGuidedReclockResidual()
+    {
+        CAutoLock objectLock(this);
+
+        // Offsets not yet taken by the rate processor, plus what it hasn't worked off yet.
+        REFERENCE_TIME residual = m_guidedReclockOffset;
+
+        if (m_guidedReclockActive)
+            residual -= m_dspRate.GetResidual();
+
+        return residual;
+    }
+
+    bool AudioRenderer::ReadDeviceSettings(DeviceSettings& settings)
+    {
+        CAutoLock objectLock(this);
+
+        {
+            LPWSTR pDeviceId = nullptr;
+
+            if (FAILED(m_settings->GetOuputDevice(&pDeviceId, &settings.outputExclusive, &settings.outputBuffer)))
+                return false;
+
+            std::unique_ptr<WCHAR, CoTaskMemFreeDeleter> holder(pDeviceId);
+            settings.outputDeviceId = pDeviceId ? pDeviceId : L"";
+        }
+
+        {
+            LPWSTR pFilePath = nullptr;
+
+            if (FAILED(m_settings->GetHeadlessDevice(&settings.headlessDevice, &pFilePath, &settings.headlessSpeed)))
+                return false;
+
+            std::unique_ptr<WCHAR, CoTaskMemFreeDeleter> holder(pFilePath);
+            settings.headlessFilePath = pFilePath ? pFilePath : L"";
+        }
+
+        return true;
+    }
+
+    bool AudioRenderer::HeadlessDeviceOutdated(bool defaultDeviceChanged)
+    {
+        CAutoLock objectLock(this);
+        assert(m_device);
+        assert(m_device->IsHeadless());
+
+        DeviceSettings settings;
+
+        if (!ReadDeviceSettings(settings))
+            return false;
+
+        const DeviceSettings& current = m_headlessDeviceSettings;
+
+        const bool outputDeviceChanged = (settings.outputDeviceId != current.outputDeviceId ||
+                                          settings.outputExclusive != current.outputExclusive ||
+                                          settings.outputBuffer != current.outputBuffer);
+
+        if (m_deviceFallback)
+        {
+            // Stands in for audio hardware, try it again only when the choice of it may have changed.
+            return settings.headlessDevice != current.headlessDevice || outputDeviceChanged ||
+                   (defaultDeviceChanged && settings.outputDeviceId.empty());
+        }
+
+        if (settings.headlessDevice != current.headlessDevice)
+            return true;
+
+        // Reopening the file would truncate what's been written to it so far.
+        if (settings.headlessDevice == ISettings2::HEADLESS_DEVICE_FILE)
+            return settings.headlessFilePath != current.headlessFilePath;
+
+        return settings.headlessSpeed != current.headlessSpeed ||
+               settings.outputBuffer != current.outputBuffer;
+    }
+
     void AudioRenderer::CheckDeviceSettings()
     {
         CAutoLock objectLock(this);
@@ -410,6 +558,22 @@ namespace SaneAudioRenderer
         if (m_device && (m_deviceSettingsSerial != newSettingsSerial ||
                          m_defaultDeviceSerial != newDefaultDeviceSerial))
         {
+            if (m_device->IsHeadless())
+            {
+                const bool defaultDeviceChanged = (m_defaultDeviceSerial != newDefaultDeviceSerial);
+
+                m_deviceSettingsSerial = newSettingsSerial;
+                m_defaultDeviceSerial = newDefaultDeviceSerial;
+
+                if (HeadlessDeviceOutdated(defaultDeviceChanged))
+                {
+                    ClearDevice();
+                    assert(!m_device);
+                }
+
+                return;
+            }
+
             bool settingsDeviceDefault;
             std::unique_ptr<WCHAR, CoTaskMemFreeDeleter> settingsDeviceId;
             BOOL settingsDeviceExclusive;
@@ -483,13 +647,33 @@ namespace SaneAudioRenderer
                 (clearForCrossfeed) ||
                 (clearForTimestretch) ||
                 (m_device->IsExclusive() != !!settingsDeviceExclusive) ||
+                (m_device->IsExclusive() && !IsBitstreaming() &&
+                 m_device->PlaysPauseSilence() != !!m_settings->GetExclusivePauseSilence()) ||
                 (m_device->GetBufferDuration() != settingsDeviceBuffer) ||
-                (!settingsDeviceDefault && *m_device->GetId() != settingsDeviceId.get()) ||
-                (settingsDeviceDefault && *m_device->GetId() != systemDeviceId.get()))
+                (!IsBitstreaming() && m_devicePullSetting != !!m_settings->GetPullMode()) ||
+                (!m_device->IsRealtime() && m_device->IsBufferAdaptive() != !!m_settings->GetAdaptiveBuffer()) ||
+                (m_device->IsExclusive() && !IsBitstreaming() &&
+                 m_device->GetLowLatencyPeriod() != m_settings->GetLowLatencyPeriod()) ||
+                (!settingsDeviceDefault && *m_device->GetId() != settingsDeviceId.get()))
             {
                 ClearDevice();
                 assert(!m_device);
             }
+            else if (settingsDeviceDefault && *m_device->GetId() != systemDeviceId.get())
+            {
+                if (m_state == State_Running)
+                {
+                    // Keep playing on the old device while the new one is being opened in the background.
+                    DebugOut(ClassName(this), "preparing device handoff");
+                    m_deviceManager.CreateDeviceAsync(m_inputFormat, m_live || m_externalClock, m_settings);
+                    m_deviceHandoff = true;
+                }
+                else
+                {
+                    ClearDevice();
+                    assert(!m_device);
+                }
+            }
         }
     }
 
@@ -518,14 +702,15 @@ namespace SaneAudioRenderer
                     if (jitter > OneMillisecond &&
                         jitter < 200 * OneMillisecond)
                     {
-                        int32_t sleepTime = (int32_t)(jitter / OneMillisecond);
-                        jitter -= sleepTime * OneMillisecond;
+                        // Hold the audio back instead of blocking until it's time to start.
+                        const size_t silenceFrames = TimeToFrames(jitter, m_device->GetRate());
 
-                        TimePeriodHelper timePeriodHelper(1);
-                        DebugOut(ClassName(this), "sleep for", sleepTime, "ms to minimize slaving jitter");
-                        Sleep(sleepTime);
-
-                        jitter = EstimateSlavingJitter();
+                        if (m_device->InsertLeadSilence(silenceFrames, deviceRenewPosition))
+                        {
+                            DebugOut(ClassName(this), "insert", silenceFrames, "frames of silence to minimize slaving jitter");
+                            m_startClockOffset -= FramesToTime(silenceFrames, m_device->GetRate());
+                            jitter = EstimateSlavingJitter();
+                        }
                     }
                     else if (m_sampleCorrection.GetLastFrameEnd() == 0)
                     {
@@ -535,13 +720,15 @@ namespace SaneAudioRenderer
                         {
                             size_t silenceFrames = m_device->GetRate() * m_device->GetBufferDuration() / 5000; // Buffer / 5
 
-                            DspChunk chunk = DspChunk(m_device->GetDspFormat(), m_device->GetChannelCount(),
+                            DspChunk chunk = DspChunk(m_device->GetQueueFormat(), m_device->GetChannelCount(),
                                                       silenceFrames, m_device->GetRate());
                             ZeroMemory(chunk.GetData(), chunk.GetSize());
 
-                            DebugOut(ClassName(this), "pushing", silenceFrames, "frames of silence");
+                            // Device queue may be shorter than that, only count what it took.
                             m_device->Push(chunk, nullptr);
+                            silenceFrames -= chunk.GetFrameCount();
 
+                            DebugOut(ClassName(this), "pushed", silenceFrames, "frames of silence");
                             m_startClockOffset -= FramesToTime(silenceFrames, m_device->GetRate());
 
                             jitter = EstimateSlavingJitter();
@@ -588,32 +775,160 @@ namespace SaneAudioRenderer
 
         if (m_device)
         {
-            m_sampleCorrection.NewDeviceBuffer();
+            InitializeDevice();
+        }
+        else
+        {
+            CreateNullDevice();
+        }
+    }
+
+    void AudioRenderer::CreateNullDevice()
+    {
+        CAutoLock objectLock(this);
+
+        assert(!m_device);
+        assert(m_inputFormat);
+
+        // Keep the graph going without audio hardware.
+        DebugOut(ClassName(this), "falling back to null device");
+
+        m_deviceSettingsSerial = m_settings->GetSerial();
+        m_defaultDeviceSerial = m_deviceManager.GetDefaultDeviceSerial();
+        m_device = m_deviceManager.CreateNullDevice(m_inputFormat, m_live || m_externalClock, m_settings);
+
+        if (m_device)
+        {
+            m_deviceFallback = true;
+            InitializeDevice();
+        }
+    }
 
-            InitializeProcessors();
+    void AudioRenderer::InitializeDevice()
+    {
+        CAutoLock objectLock(this);
 
-            m_startClockOffset = m_sampleCorrection.GetLastFrameEnd();
+        assert(m_device);
 
-            if (m_state == State_Running)
+        // Headless devices are recreated only when settings that concern them change.
+        if (m_device->IsHeadless())
+            ReadDeviceSettings(m_headlessDeviceSettings);
+
+        m_device->SetProgressEvent(m_deviceProgress);
+
+        m_devicePullSetting = !!m_settings->GetPullMode();
+
+        if (m_devicePullSetting && !IsBitstreaming())
+        {
+            try
             {
-                try
-                {
-                    PushReslavingJitter();
-                }
-                catch (HRESULT)
-                {
-                    ClearDevice();
-                }
+                m_pullMode = m_device->SetRenderCallback(std::bind(&AudioRenderer::RenderPulled, this,
+                                                                   std::placeholders::_1,
+                                                                   std::placeholders::_2,
+                                                                   std::placeholders::_3));
+            }
+            catch (std::bad_alloc&)
+            {
+                m_pullMode = false;
+            }
+        }
 
-                StartDevice();
+        m_sampleCorrection.NewDeviceBuffer();
+
+        InitializeProcessors();
+
+        m_startClockOffset = m_sampleCorrection.GetLastFrameEnd();
+
+        if (m_state == State_Running)
+        {
+            try
+            {
+                PushReslavingJitter();
             }
+            catch (HRESULT)
+            {
+                ClearDevice();
+            }
+
+            StartDevice();
         }
     }
 
+    void AudioRenderer::HandOffDevice()
+    {
+        CAutoLock objectLock(this);
+        assert(m_deviceHandoff);
+        assert(m_device);
+
+        DebugOut(ClassName(this), "handing off to new default device");
+
+        // The old device plays out what's already queued in it, and the new one starts with
+        // the same amount of silence when it's slaved (see PushReslavingJitter()).
+        std::unique_ptr<AudioDevice> oldDevice;
+        int64_t oldDeviceEnd = 0;
+
+        try
+        {
+            oldDeviceEnd = m_device->GetEnd();
+            m_device->Finish(nullptr);
+            m_device->SetProgressEvent(NULL);
+
+            m_myClock.UnslaveClockFromAudio();
+            oldDevice = std::move(m_device);
+        }
+        catch (HRESULT)
+        {
+            // Failed device has nothing to play out.
+        }
+
+        // The new device is picked up from the background creation, clock is reslaved to it on start.
+        ClearDevice();
+        CreateDevice();
+
+        if (oldDevice)
+        {
+            m_retiredDevice = std::move(oldDevice);
+            m_retiredDeviceEnd = oldDeviceEnd;
+        }
+        else if (m_device && !IsBitstreaming())
+        {
+            // Soften the cut, what's left in the old device buffer is gone.
+            m_dspVolume.FadeIn(m_device->GetRate() / 100);
+        }
+    }
+
+    void AudioRenderer::ReleaseRetiredDevice(bool force)
+    {
+        CAutoLock objectLock(this);
+
+        if (!m_retiredDevice)
+            return;
+
+        if (!force)
+        {
+            try
+            {
+                if (m_retiredDevice->GetPosition() < m_retiredDeviceEnd)
+                    return;
+            }
+            catch (HRESULT)
+            {
+                // Failed device has nothing more to play.
+            }
+        }
+
+        DebugOut(ClassName(this), "releasing handed off device");
+
+        m_retiredDevice->Stop();
+        m_retiredDevice = nullptr;
+    }
+
     void AudioRenderer::ClearDevice()
     {
         CAutoLock objectLock(this);
 
+        ReleaseRetiredDevice(true);
+
         if (m_device)
         {
             if (m_state == State_Running)
@@ -624,9 +939,23 @@ namespace SaneAudioRenderer
             m_device = nullptr;
         }
 
+        m_deviceFlushed = false;
+        m_deviceHandoff = false;
+        m_deviceFallback = false;
+        m_deviceFailed = false;
+        m_pullMode = false;
         m_dropNextFrames = 0;
     }
 
+    void AudioRenderer::RenderPulled(float* data, size_t frames, uint32_t channels)
+    {
+        // Called from the device thread, can't lock or allocate here.
+        const size_t samples = frames * channels;
+
+        DspVolume::Apply(data, samples, m_volume);
+        DspBalance::Apply(data, samples, channels, m_balance);
+    }
+
     REFERENCE_TIME AudioRenderer::EstimateSlavingJitter()
     {
         CAutoLock objectLock(this);
@@ -666,20 +995,82 @@ namespace SaneAudioRenderer
         {
             jitter = std::min(jitter, llMulDiv(m_device->GetBufferDuration(), OneSecond, 1000, 0));
 
-            DspChunk chunk(m_device->GetDspFormat(), m_device->GetChannelCount(),
+            DspChunk chunk(m_device->GetQueueFormat(), m_device->GetChannelCount(),
                            TimeToFrames(jitter, m_device->GetRate()), m_device->GetRate());
 
             if (!chunk.IsEmpty())
             {
-                m_startClockOffset -= FramesToTime(chunk.GetFrameCount(), m_device->GetRate());
+                ZeroMemory(chunk.GetData(), chunk.GetSize());
 
-                DebugOut(ClassName(this), "push", chunk.GetFrameCount() * 1000. / m_device->GetRate(),
+                // The device isn't started yet and can't drain, so only what fits in its queue
+                // right away is pushed. Waiting for more space here would never end.
+                const size_t chunkFrames = chunk.GetFrameCount();
+
+                try
+                {
+                    m_device->Push(chunk, nullptr);
+                }
+                catch (HRESULT)
+                {
+                    ClearDevice();
+                    return;
+                }
+
+                const size_t pushedFrames = chunkFrames - chunk.GetFrameCount();
+
+                m_startClockOffset -= FramesToTime(pushedFrames, m_device->GetRate());
+
+                DebugOut(ClassName(this), "push", pushedFrames * 1000. / m_device->GetRate(),
                          "ms of silence to minimize re-slaving jitter");
+            }
+        }
+    }
 
-                ZeroMemory(chunk.GetData(), chunk.GetSize());
-                PushToDevice(chunk, nullptr);
+    void AudioRenderer::PushFlushedDevice(DspChunk& chunk, CAMEvent* pFilledEvent)
+    {
+        CAutoLock objectLock(this);
+
+        assert(m_device);
+        assert(m_deviceFlushed);
+        assert(m_state == State_Running);
+        assert(!chunk.IsEmpty());
+
+        // Flushed device plays silence until new audio arrives,
+        // and reports the position where it's going to land as its end.
+        REFERENCE_TIME chunkStart = m_startClockOffset;
+        m_startClockOffset = chunkStart - m_device->GetEnd();
+
+        if (!IsBitstreaming())
+        {
+            // Try to keep inevitable clock jerking to a minimum after re-slaving.
+            REFERENCE_TIME jitter = EstimateSlavingJitter();
+
+            if (jitter > 0)
+            {
+                jitter = std::min(jitter, llMulDiv(m_device->GetBufferDuration(), OneSecond, 1000, 0));
+
+                size_t padFrames = TimeToFrames(jitter, m_device->GetRate());
+                chunk.PadHead(padFrames);
+                chunkStart -= FramesToTime(padFrames, m_device->GetRate());
+
+                DebugOut(ClassName(this), "pad", padFrames * 1000. / m_device->GetRate(),
+                         "ms of silence to minimize re-slaving jitter");
             }
         }
+
+        const size_t chunkFrames = chunk.GetFrameCount();
+
+        // Device queue may not take the whole chunk, the rest goes through the regular path.
+        m_device->Push(chunk, pFilledEvent);
+
+        m_deviceFlushed = false;
+
+        const REFERENCE_TIME pushedDuration = FramesToTime(chunkFrames - chunk.GetFrameCount(), m_device->GetRate());
+        m_startClockOffset = chunkStart - (m_device->GetEnd() - pushedDuration);
+
+        m_guidedReclockOffset = 0;
+        m_myClock.SlaveClockToAudio(m_device->GetClock(), m_startTime + m_startClockOffset);
+        m_clockCorrection = 0;
     }
 
     void AudioRenderer::ApplyClockCorrection()
@@ -694,6 +1085,7 @@ namespace SaneAudioRenderer
             if (std::abs(offset) > 100)
             {
                 m_myClock.OffsetAudioClock(offset);
+                m_myClock.GetStats().Record(IClockStats::CLOCK_STATS_OFFSET, offset);
                 m_clockCorrection += offset;
                 DebugOut(ClassName(this), "offset internal clock by", offset / 10000.,
                          "ms to match", ClassName(&m_sampleCorrection));
@@ -720,25 +1112,43 @@ namespace SaneAudioRenderer
 
         if (m_live)
         {
-            // Rate matching.
-            if (remaining > latency) // x2.0
+            // Rate matching, steering the resampling ratio towards the target latency.
+            // Whole frames are dropped or padded only on gross errors.
+            REFERENCE_TIME targetLatency = latency * 3 / 4; // x1.5
+
+            if (UINT32 targetLatencyMs = m_settings->GetLiveTargetLatency())
+                targetLatency = std::max(m_device->GetStreamLatency(), targetLatencyMs * OneMillisecond);
+
+            const REFERENCE_TIME grossError = std::max(targetLatency, 20 * OneMillisecond);
+
+            if (remaining > targetLatency + grossError)
             {
-                size_t dropFrames = TimeToFrames(remaining - latency * 3 / 4, m_device->GetRate()); // x1.5
+                size_t dropFrames = TimeToFrames(remaining - targetLatency, m_device->GetRate());
 
                 dropFrames = std::min(dropFrames, chunk.GetFrameCount());
 
                 chunk.ShrinkHead(chunk.GetFrameCount() - dropFrames);
 
+                m_myClock.GetStats().Record(IClockStats::CLOCK_STATS_DROP, FramesToTime(dropFrames, m_device->GetRate()));
+
                 DebugOut(ClassName(this), "drop", dropFrames, "frames for rate matching");
             }
-            else if (remaining < latency / 2) // x1.0
+            else if (remaining < targetLatency / 2)
             {
-                size_t padFrames = TimeToFrames(latency * 3 / 4 - remaining, m_device->GetRate()); // x1.5
+                size_t padFrames = TimeToFrames(targetLatency - remaining, m_device->GetRate());
 
                 chunk.PadHead(padFrames);
 
+                m_myClock.GetStats().Record(IClockStats::CLOCK_STATS_PAD, FramesToTime(padFrames, m_device->GetRate()));
+
                 DebugOut(ClassName(this), "pad", padFrames, "frames for rate matching");
             }
+            else
+            {
+                // Keep the outstanding rate adjustment equal to the current latency error,
+                // the rate controller works it off gradually.
+                m_dspRate.Adjust(targetLatency - remaining - m_dspRate.GetResidual());
+            }
         }
         else
         {
@@ -766,6 +1176,7 @@ namespace SaneAudioRenderer
                         chunk.PadHead(padFrames);
 
                         REFERENCE_TIME paddedTime = FramesToTime(padFrames, m_device->GetRate());
+                        m_myClock.GetStats().Record(IClockStats::CLOCK_STATS_PAD, paddedTime);
 
                         m_myClock.OffsetAudioClock(-paddedTime);
                         padTime -= paddedTime;
@@ -795,6 +1206,7 @@ namespace SaneAudioRenderer
                         chunk.ShrinkHead(chunk.GetFrameCount() - dropFrames);
 
                         REFERENCE_TIME droppedTime = FramesToTime(dropFrames, m_device->GetRate());
+                        m_myClock.GetStats().Record(IClockStats::CLOCK_STATS_DROP, droppedTime);
 
                         m_myClock.OffsetAudioClock(droppedTime);
                         dropTime -= droppedTime;
@@ -847,15 +1259,31 @@ namespace SaneAudioRenderer
         m_dspDither.Initialize(m_device->GetDspFormat());
     }
 
+    void AudioRenderer::ResetProcessors()
+    {
+        CAutoLock objectLock(this);
+        assert(m_device);
+
+        if (IsBitstreaming())
+            return;
+
+        auto f = [&](DspBase* pDsp)
+        {
+            pDsp->Reset();
+        };
+
+        EnumerateProcessors(f);
+    }
+
     bool AudioRenderer::PushToDevice(DspChunk& chunk, CAMEvent* pFilledEvent)
     {
         bool firstIteration = true;
-        uint32_t sleepDuration = 0;
+        DWORD waitDuration = 0;
         while (!chunk.IsEmpty())
         {
             // The device buffer is full or almost full at the beginning of the second and subsequent iterations.
-            // Sleep until the buffer may have significant amount of free space. Unless interrupted.
-            if (!firstIteration && m_flush.Wait(sleepDuration))
+            // Wait until the buffer has significant amount of free space. Unless interrupted.
+            if (!firstIteration && WaitForAny(waitDuration, m_flush, m_deviceProgress) == WAIT_OBJECT_0)
                 return false;
 
             firstIteration = false;
@@ -869,35 +1297,79 @@ namespace SaneAudioRenderer
                 try
                 {
                     m_device->Push(chunk, pFilledEvent);
-                    sleepDuration = m_device->GetBufferDuration() / 4;
+
+                    if (pFilledEvent && m_state == State_Paused)
+                        CheckStartPrebuffer(*pFilledEvent);
+
+                    // Devices that signal progress get a generous timeout just in case they stop (pause, error).
+                    waitDuration = m_device->SignalsProgress() ? m_device->GetBufferDuration() :
+                                       std::max<DWORD>(1, (DWORD)(m_device->GetRefillDelay() / OneMillisecond));
                 }
                 catch (HRESULT)
                 {
                     ClearDevice();
-                    sleepDuration = 0;
+                    waitDuration = 0;
                 }
             }
             else
             {
-                // The code below emulates null audio device.
+                // Null device takes the rest, until the next sample brings up a new one.
+                CreateNullDevice();
 
-                if (pFilledEvent)
-                    pFilledEvent->Set();
+                if (!m_device)
+                {
+                    if (pFilledEvent)
+                        pFilledEvent->Set();
 
-                sleepDuration = 1;
+                    break;
+                }
 
-                // Loop until the graph time passes the current sample end minus 50ms.
-                REFERENCE_TIME graphTime;
-                if (m_state == State_Running &&
-                    SUCCEEDED(m_graphClock->GetTime(&graphTime)) &&
-                    graphTime + 50 * OneMillisecond > m_startTime + m_sampleCorrection.GetLastFrameEnd() +
-                                                      m_sampleCorrection.GetTimeDivergence())
+                m_deviceFailed = true;
+
+                if (!IsBitstreaming())
                 {
-                    break;
+                    // What's left was made for the failed device, keep its duration as silence.
+                    DspChunk silence(m_device->GetQueueFormat(), m_device->GetChannelCount(),
+                                     (size_t)llMulDiv(chunk.GetFrameCount(), m_device->GetRate(), chunk.GetRate(), 0),
+                                     m_device->GetRate());
+                    ZeroMemory(silence.GetData(), silence.GetSize());
+                    chunk = std::move(silence);
                 }
+
+                waitDuration = 0;
             }
         }
 
         return true;
     }
+
+    void AudioRenderer::CheckStartPrebuffer(CAMEvent& filledEvent)
+    {
+        CAutoLock objectLock(this);
+
+        assert(m_device);
+        assert(m_state == State_Paused);
+
+        // Complete the pause transition before the device buffer is full, the rest of it fills up
+        // during playback. Bitstreaming and live sources keep waiting, underruns hurt them the most.
+        if (IsBitstreaming() || m_live)
+            return;
+
+        const UINT32 periods = m_settings->GetStartPrebuffer();
+
+        if (periods == ISettings2::START_PREBUFFER_FULL)
+            return;
+
+        // Headless devices don't have a period, assume the usual shared mode one.
+        REFERENCE_TIME period = m_device->GetDevicePeriod();
+        if (period <= 0)
+            period = 10 * OneMillisecond;
+
+        // Never less than the stream needs to keep running, never more than the buffer can hold.
+        REFERENCE_TIME threshold = std::max(periods * period, m_device->GetStreamLatency());
+        threshold = std::min(threshold, OneMillisecond * m_device->GetBufferDuration());
+
+        if (m_device->GetEnd() - m_device->GetPosition() >= threshold)
+            filledEvent.Set();
+    }
 }
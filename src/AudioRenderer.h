@@ -23,7 +23,7 @@ namespace SaneAudioRenderer
     {
     public:
 
-        AudioRenderer(ISettings* pSettings, MyClock& clock, HRESULT& result);
+        AudioRenderer(ISettings2* pSettings, MyClock& clock, HRESULT& result);
         AudioRenderer(const AudioRenderer&) = delete;
         AudioRenderer& operator=(const AudioRenderer&) = delete;
         ~AudioRenderer();
@@ -59,25 +59,48 @@ namespace SaneAudioRenderer
         bool OnExternalClock() const { return m_externalClock; }
         bool IsLive()          const { return m_live; }
         bool IsBitstreaming()  const { return m_bitstreaming; }
+        bool IsPullMode()      const { return m_pullMode; }
 
         bool OnGuidedReclock();
+        REFERENCE_TIME GetGuidedReclockResidual();
 
     private:
 
+        struct DeviceSettings final
+        {
+            std::wstring outputDeviceId;
+            BOOL outputExclusive = FALSE;
+            UINT32 outputBuffer = 0;
+            UINT32 headlessDevice = ISettings2::HEADLESS_DEVICE_NONE;
+            std::wstring headlessFilePath;
+            UINT32 headlessSpeed = 0;
+        };
+
+        bool ReadDeviceSettings(DeviceSettings& settings);
+        bool HeadlessDeviceOutdated(bool defaultDeviceChanged);
+
         void CheckDeviceSettings();
         void StartDevice();
         void CreateDevice();
+        void CreateNullDevice();
+        void InitializeDevice();
+        void HandOffDevice();
+        void ReleaseRetiredDevice(bool force);
         void ClearDevice();
 
+        void RenderPulled(float* data, size_t frames, uint32_t channels);
+
         REFERENCE_TIME EstimateSlavingJitter();
 
         void PushReslavingJitter();
+        void PushFlushedDevice(DspChunk& chunk, CAMEvent* pFilledEvent);
 
         void ApplyClockCorrection();
 
         void ApplyRateCorrection(DspChunk& chunk);
 
         void InitializeProcessors();
+        void ResetProcessors();
 
         template <typename F>
         void EnumerateProcessors(F f)
@@ -98,9 +121,19 @@ namespace SaneAudioRenderer
         }
 
         bool PushToDevice(DspChunk& chunk, CAMEvent* pFilledEvent);
+        void CheckStartPrebuffer(CAMEvent& filledEvent);
 
         AudioDeviceManager m_deviceManager;
+        CAMEvent m_deviceProgress;
         std::unique_ptr<AudioDevice> m_device;
+        std::unique_ptr<AudioDevice> m_retiredDevice;
+        int64_t m_retiredDeviceEnd = 0;
+        bool m_deviceFlushed = false;
+        bool m_deviceHandoff = false;
+        bool m_devicePullSetting = false;
+        bool m_deviceFallback = false;
+        bool m_deviceFailed = false;
+        DeviceSettings m_headlessDeviceSettings;
 
         FILTER_STATE m_state = State_Stopped;
 
@@ -113,6 +146,7 @@ namespace SaneAudioRenderer
         std::atomic<bool> m_externalClock = false;
         std::atomic<bool> m_live = false;
         std::atomic<bool> m_bitstreaming = false;
+        std::atomic<bool> m_pullMode = false;
 
         SharedWaveFormat m_inputFormat;
 
@@ -135,7 +169,7 @@ namespace SaneAudioRenderer
         DspLimiter m_dspLimiter;
         DspDither m_dspDither;
 
-        ISettingsPtr m_settings;
+        ISettings2Ptr m_settings;
         UINT32 m_deviceSettingsSerial = 0;
 
         uint32_t m_defaultDeviceSerial = 0;
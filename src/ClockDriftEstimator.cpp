@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "ClockDriftEstimator.h"
+
+namespace SaneAudioRenderer
+{
+    namespace
+    {
+        const double ForgettingTimeConstant = 120.0;
+
+        const size_t MinSamples = 20;
+        const double MinSpan = 1.0;
+    }
+
+    void ClockDriftEstimator::AddSample(int64_t counterTime, int64_t positionTime)
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            m_originCounterTime = counterTime;
+            m_originPositionTime = positionTime;
+            m_lastCounterTime = counterTime;
+        }
+
+        if (counterTime < m_lastCounterTime)
+            return;
+
+        if (m_rebase)
+        {
+            // Shift the position origin so that the new sample lands on the current fit.
+            m_rebase = false;
+
+            const double x = (double)(counterTime - m_originCounterTime) / OneSecond;
+            const double y = (double)((positionTime - m_originPositionTime) - (counterTime - m_originCounterTime)) / OneSecond;
+
+            double fitY = y;
+            if (m_sumW > 0.0)
+            {
+                const double varX = m_sumXX - m_sumX * m_sumX / m_sumW;
+                const double slope = (varX > 0.0) ? (m_sumXY - m_sumX * m_sumY / m_sumW) / varX : 0.0;
+                fitY = m_sumY / m_sumW + slope * (x - m_sumX / m_sumW);
+            }
+
+            m_originPositionTime += (int64_t)((y - fitY) * OneSecond);
+        }
+
+        // Age the accumulated samples.
+        const double decay = std::exp(-(double)(counterTime - m_lastCounterTime) / OneSecond / ForgettingTimeConstant);
+        m_lastCounterTime = counterTime;
+
+        m_sumW *= decay;
+        m_sumX *= decay;
+        m_sumY *= decay;
+        m_sumXX *= decay;
+        m_sumXY *= decay;
+        m_sumYY *= decay;
+
+        const double x = (double)(counterTime - m_originCounterTime) / OneSecond;
+        const double y = (double)((positionTime - m_originPositionTime) - (counterTime - m_originCounterTime)) / OneSecond;
+
+        m_sumW += 1.0;
+        m_sumX += x;
+        m_sumY += y;
+        m_sumXX += x * x;
+        m_sumXY += x * y;
+        m_sumYY += y * y;
+
+        m_samples++;
+    }
+
+    bool ClockDriftEstimator::GetDrift(double& driftPpm, double& errorPpm) const
+    {
+        if (m_samples < MinSamples)
+            return false;
+
+        const double varX = m_sumXX - m_sumX * m_sumX / m_sumW;
+        const double covXY = m_sumXY - m_sumX * m_sumY / m_sumW;
+        const double varY = m_sumYY - m_sumY * m_sumY / m_sumW;
+
+        if (varX < MinSpan * MinSpan * m_sumW / 12)
+            return false;
+
+        const double slope = covXY / varX;
+        const double residual = std::max(0.0, varY - slope * covXY);
+
+        driftPpm = slope * 1000000.0;
+        errorPpm = std::sqrt(residual / std::max(1.0, m_sumW - 2.0) / varX) * 1000000.0;
+
+        return true;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // Weighted least squares fit of device position against the performance counter,
+    // with exponential forgetting so that it follows slow thermal drift.
+    class ClockDriftEstimator final
+    {
+    public:
+
+        ClockDriftEstimator() = default;
+        ClockDriftEstimator(const ClockDriftEstimator&) = delete;
+        ClockDriftEstimator& operator=(const ClockDriftEstimator&) = delete;
+
+        void AddSample(int64_t counterTime, int64_t positionTime);
+
+        // Device position is about to jump (reslaving, device reset), the drift carries on.
+        void Rebase() { m_rebase = true; }
+
+        bool GetDrift(double& driftPpm, double& errorPpm) const;
+
+    private:
+
+        bool m_started = false;
+        int64_t m_originCounterTime = 0;
+        int64_t m_originPositionTime = 0;
+        int64_t m_lastCounterTime = 0;
+        bool m_rebase = false;
+
+        // In seconds relative to the origin, y is position minus counter.
+        double m_sumW = 0.0;
+        double m_sumX = 0.0;
+        double m_sumY = 0.0;
+        double m_sumXX = 0.0;
+        double m_sumXY = 0.0;
+        double m_sumYY = 0.0;
+
+        size_t m_samples = 0;
+    };
+}
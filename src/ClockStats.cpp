@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "ClockStats.h"
+
+namespace SaneAudioRenderer
+{
+    namespace
+    {
+        const std::array<REFERENCE_TIME, IClockStats::CLOCK_STATS_BINS - 1> BinBounds = {
+            OneMillisecond / 10,
+            OneMillisecond / 2,
+            OneMillisecond,
+            5 * OneMillisecond,
+            10 * OneMillisecond,
+            50 * OneMillisecond,
+            100 * OneMillisecond,
+        };
+    }
+
+    void ClockStats::Record(uint32_t kind, REFERENCE_TIME time)
+    {
+        assert(kind < m_histograms.size());
+        Histogram& histogram = m_histograms[kind];
+
+        time = std::abs(time);
+
+        histogram.events++;
+        histogram.totalTime += time;
+
+        int64_t maxTime = histogram.maxTime;
+        while (time > maxTime && !histogram.maxTime.compare_exchange_weak(maxTime, time));
+
+        const size_t bin = std::upper_bound(BinBounds.begin(), BinBounds.end(), time - 1) - BinBounds.begin();
+        histogram.bins[bin]++;
+    }
+
+    HRESULT ClockStats::Get(uint32_t kind, UINT64* pEvents, LONGLONG* pTotalTime, LONGLONG* pMaxTime, UINT64* pBins)
+    {
+        if (kind >= m_histograms.size())
+            return E_INVALIDARG;
+
+        const Histogram& histogram = m_histograms[kind];
+
+        if (pEvents)
+            *pEvents = histogram.events;
+
+        if (pTotalTime)
+            *pTotalTime = histogram.totalTime;
+
+        if (pMaxTime)
+            *pMaxTime = histogram.maxTime;
+
+        if (pBins)
+        {
+            for (size_t i = 0; i < histogram.bins.size(); i++)
+                pBins[i] = histogram.bins[i];
+        }
+
+        return S_OK;
+    }
+
+    void ClockStats::Reset()
+    {
+        for (Histogram& histogram : m_histograms)
+        {
+            histogram.events = 0;
+            histogram.totalTime = 0;
+            histogram.maxTime = 0;
+
+            for (auto& bin : histogram.bins)
+                bin = 0;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../IClockStats.h"
+
+namespace SaneAudioRenderer
+{
+    // Clock health counters, kept in release builds too. Safe to update from any thread.
+    class ClockStats final
+    {
+    public:
+
+        ClockStats() { Reset(); }
+        ClockStats(const ClockStats&) = delete;
+        ClockStats& operator=(const ClockStats&) = delete;
+
+        void Record(uint32_t kind, REFERENCE_TIME time);
+
+        HRESULT Get(uint32_t kind, UINT64* pEvents, LONGLONG* pTotalTime, LONGLONG* pMaxTime, UINT64* pBins);
+        void Reset();
+
+    private:
+
+        struct Histogram
+        {
+            std::atomic<uint64_t> events;
+            std::atomic<int64_t> totalTime;
+            std::atomic<int64_t> maxTime;
+            std::array<std::atomic<uint64_t>, IClockStats::CLOCK_STATS_BINS> bins;
+        };
+
+        std::array<Histogram, IClockStats::CLOCK_STATS_COUNT> m_histograms;
+    };
+}
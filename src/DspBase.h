@@ -1,20 +1,23 @@
-#pragma once
-
-#include "DspChunk.h"
-
-namespace SaneAudioRenderer
-{
-    class DspBase
-    {
-    public:
-
-        virtual ~DspBase() = default;
-
-        virtual std::wstring Name() = 0;
-
-        virtual bool Active() = 0;
-
-        virtual void Process(DspChunk& chunk) = 0;
-        virtual void Finish(DspChunk& chunk) = 0;
-    };
-}
+#pragma once
+
+#include "DspChunk.h"
+
+namespace SaneAudioRenderer
+{
+    class DspBase
+    {
+    public:
+
+        virtual ~DspBase() = default;
+
+        virtual std::wstring Name() = 0;
+
+        virtual bool Active() = 0;
+
+        virtual void Process(DspChunk& chunk) = 0;
+        virtual void Finish(DspChunk& chunk) = 0;
+
+        // Clears processing state without reallocating.
+        virtual void Reset() = 0;
+    };
+}
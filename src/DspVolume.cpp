@@ -1,32 +1,60 @@
-#include "pch.h"
-#include "DspVolume.h"
-
-#include "AudioRenderer.h"
-
-namespace SaneAudioRenderer
-{
-    bool DspVolume::Active()
-    {
-        return m_renderer.GetVolume() != 1.0f;
-    }
-
-    void DspVolume::Process(DspChunk& chunk)
-    {
-        const float volume = m_renderer.GetVolume();
-        assert(volume >= 0.0f && volume <= 1.0f);
-
-        if (volume == 1.0f || chunk.IsEmpty())
-            return;
-
-        DspChunk::ToFloat(chunk);
-
-        auto data = reinterpret_cast<float*>(chunk.GetData());
-        for (size_t i = 0, n = chunk.GetSampleCount(); i < n; i++)
-            data[i] *= volume;
-    }
-
-    void DspVolume::Finish(DspChunk& chunk)
-    {
-        Process(chunk);
-    }
-}
+#include "pch.h"
+#include "DspVolume.h"
+
+#include "AudioRenderer.h"
+
+namespace SaneAudioRenderer
+{
+    bool DspVolume::Active()
+    {
+        // Pulling device applies the volume itself, only the fade stays here.
+        return (!m_renderer.IsPullMode() && m_renderer.GetVolume() != 1.0f) || m_fadePosition < m_fadeFrames;
+    }
+
+    void DspVolume::Apply(float* data, size_t samples, float volume)
+    {
+        if (volume == 1.0f)
+            return;
+
+        for (size_t i = 0; i < samples; i++)
+            data[i] *= volume;
+    }
+
+    void DspVolume::Process(DspChunk& chunk)
+    {
+        const float volume = m_renderer.IsPullMode() ? 1.0f : m_renderer.GetVolume();
+        assert(volume >= 0.0f && volume <= 1.0f);
+
+        const bool fading = m_fadePosition < m_fadeFrames;
+
+        if ((volume == 1.0f && !fading) || chunk.IsEmpty())
+            return;
+
+        DspChunk::ToFloat(chunk);
+
+        auto data = reinterpret_cast<float*>(chunk.GetData());
+
+        if (fading)
+        {
+            const size_t channels = chunk.GetChannelCount();
+
+            for (size_t frame = 0, n = chunk.GetFrameCount(); frame < n; frame++)
+            {
+                const float gain = (m_fadePosition < m_fadeFrames) ?
+                                   volume * m_fadePosition++ / m_fadeFrames : volume;
+
+                for (size_t i = 0; i < channels; i++)
+                    data[frame * channels + i] *= gain;
+            }
+        }
+        else
+        {
+            Apply(data, chunk.GetSampleCount(), volume);
+        }
+    }
+
+    void DspVolume::Finish(DspChunk& chunk)
+    {
+        Process(chunk);
+    }
+}
@@ -1,29 +1,39 @@
-#pragma once
-
-#include "DspBase.h"
-
-namespace SaneAudioRenderer
-{
-    class AudioRenderer;
-
-    class DspVolume final
-        : public DspBase
-    {
-    public:
-
-        DspVolume(AudioRenderer& renderer) : m_renderer(renderer) {}
-        DspVolume(const DspVolume&) = delete;
-        DspVolume& operator=(const DspVolume&) = delete;
-
-        std::wstring Name() override { return L"Volume"; }
-
-        bool Active() override;
-
-        void Process(DspChunk& chunk) override;
-        void Finish(DspChunk& chunk) override;
-
-    private:
-
-        const AudioRenderer& m_renderer;
-    };
-}
+#pragma once
+
+#include "DspBase.h"
+
+namespace SaneAudioRenderer
+{
+    class AudioRenderer;
+
+    class DspVolume final
+        : public DspBase
+    {
+    public:
+
+        DspVolume(AudioRenderer& renderer) : m_renderer(renderer) {}
+        DspVolume(const DspVolume&) = delete;
+        DspVolume& operator=(const DspVolume&) = delete;
+
+        std::wstring Name() override { return L"Volume"; }
+
+        bool Active() override;
+
+        void Process(DspChunk& chunk) override;
+        void Finish(DspChunk& chunk) override;
+
+        void Reset() override { m_fadeFrames = 0; }
+
+        // Ramps up from silence over the next frames.
+        void FadeIn(size_t frames) { m_fadeFrames = frames; m_fadePosition = 0; }
+
+        static void Apply(float* data, size_t samples, float volume);
+
+    private:
+
+        const AudioRenderer& m_renderer;
+
+        size_t m_fadeFrames = 0;
+        size_t m_fadePosition = 0;
+    };
+}
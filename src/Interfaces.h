@@ -1,61 +1,127 @@
-#pragma once
-
-#include <comdef.h>
-#include <ocidl.h>
-
-namespace SaneAudioRenderer
-{
-    struct __declspec(uuid("ED41579C-C96A-4D8C-9813-856AB99F405E"))
-    ISettings : IUnknown
-    {
-        STDMETHOD_(UINT32, GetSerial)() = 0;
-
-        enum
-        {
-            OUTPUT_DEVICE_BUFFER_MIN_MS = 60,
-            OUTPUT_DEVICE_BUFFER_MAX_MS = 1000,
-            OUTPUT_DEVICE_BUFFER_DEFAULT_MS = 200,
-        };
-        STDMETHOD(SetOuputDevice)(LPCWSTR pDeviceId, BOOL bExclusive, UINT32 uBufferMS) = 0;
-        STDMETHOD(GetOuputDevice)(LPWSTR* ppDeviceId, BOOL* pbExclusive, UINT32* puBufferMS) = 0;
-
-        STDMETHOD_(void, SetAllowBitstreaming)(BOOL bAllowBitstreaming) = 0;
-        STDMETHOD_(BOOL, GetAllowBitstreaming)() = 0;
-
-        STDMETHOD_(void, SetCrossfeedEnabled)(BOOL bEnable) = 0;
-        STDMETHOD_(BOOL, GetCrossfeedEnabled)() = 0;
-
-        enum
-        {
-            CROSSFEED_CUTOFF_FREQ_MIN = 300,
-            CROSSFEED_CUTOFF_FREQ_MAX = 2000,
-            CROSSFEED_CUTOFF_FREQ_CMOY = 700,
-            CROSSFEED_CUTOFF_FREQ_JMEIER = 650,
-            CROSSFEED_LEVEL_MIN = 10,
-            CROSSFEED_LEVEL_MAX = 150,
-            CROSSFEED_LEVEL_CMOY = 60,
-            CROSSFEED_LEVEL_JMEIER = 95,
-        };
-        STDMETHOD(SetCrossfeedSettings)(UINT32 uCutoffFrequency, UINT32 uCrossfeedLevel) = 0;
-        STDMETHOD_(void, GetCrossfeedSettings)(UINT32* puCutoffFrequency, UINT32* puCrossfeedLevel) = 0;
-
-        STDMETHOD_(void, SetIgnoreSystemChannelMixer)(BOOL bEnable) = 0;
-        STDMETHOD_(BOOL, GetIgnoreSystemChannelMixer)() = 0;
-
-        enum
-        {
-            TIMESTRETCH_METHOD_SOLA = 0,
-            TIMESTRETCH_METHOD_PHASE_VOCODER = 1,
-        };
-        STDMETHOD(SetTimestretchSettings)(UINT32 uTimestretchMethod) = 0;
-        STDMETHOD_(void, GetTimestretchSettings)(UINT32* puTimestretchMethod) = 0;
-    };
-    _COM_SMARTPTR_TYPEDEF(ISettings, __uuidof(ISettings));
-
-    struct __declspec(uuid("03481710-D73E-4674-839F-03EDE2D60ED8"))
-    ISpecifyPropertyPages2 : ISpecifyPropertyPages
-    {
-        STDMETHOD(CreatePage)(const GUID& guid, IPropertyPage** ppPage) = 0;
-    };
-    _COM_SMARTPTR_TYPEDEF(ISpecifyPropertyPages2, __uuidof(ISpecifyPropertyPages2));
-}
+#pragma once
+
+#include <comdef.h>
+#include <ocidl.h>
+
+namespace SaneAudioRenderer
+{
+    struct __declspec(uuid("ED41579C-C96A-4D8C-9813-856AB99F405E"))
+    ISettings : IUnknown
+    {
+        STDMETHOD_(UINT32, GetSerial)() = 0;
+
+        enum
+        {
+            OUTPUT_DEVICE_BUFFER_MIN_MS = 60,
+            OUTPUT_DEVICE_BUFFER_MAX_MS = 1000,
+            OUTPUT_DEVICE_BUFFER_DEFAULT_MS = 200,
+        };
+        STDMETHOD(SetOuputDevice)(LPCWSTR pDeviceId, BOOL bExclusive, UINT32 uBufferMS) = 0;
+        STDMETHOD(GetOuputDevice)(LPWSTR* ppDeviceId, BOOL* pbExclusive, UINT32* puBufferMS) = 0;
+
+        STDMETHOD_(void, SetAllowBitstreaming)(BOOL bAllowBitstreaming) = 0;
+        STDMETHOD_(BOOL, GetAllowBitstreaming)() = 0;
+
+        STDMETHOD_(void, SetCrossfeedEnabled)(BOOL bEnable) = 0;
+        STDMETHOD_(BOOL, GetCrossfeedEnabled)() = 0;
+
+        enum
+        {
+            CROSSFEED_CUTOFF_FREQ_MIN = 300,
+            CROSSFEED_CUTOFF_FREQ_MAX = 2000,
+            CROSSFEED_CUTOFF_FREQ_CMOY = 700,
+            CROSSFEED_CUTOFF_FREQ_JMEIER = 650,
+            CROSSFEED_LEVEL_MIN = 10,
+            CROSSFEED_LEVEL_MAX = 150,
+            CROSSFEED_LEVEL_CMOY = 60,
+            CROSSFEED_LEVEL_JMEIER = 95,
+        };
+        STDMETHOD(SetCrossfeedSettings)(UINT32 uCutoffFrequency, UINT32 uCrossfeedLevel) = 0;
+        STDMETHOD_(void, GetCrossfeedSettings)(UINT32* puCutoffFrequency, UINT32* puCrossfeedLevel) = 0;
+
+        STDMETHOD_(void, SetIgnoreSystemChannelMixer)(BOOL bEnable) = 0;
+        STDMETHOD_(BOOL, GetIgnoreSystemChannelMixer)() = 0;
+
+        enum
+        {
+            TIMESTRETCH_METHOD_SOLA = 0,
+            TIMESTRETCH_METHOD_PHASE_VOCODER = 1,
+        };
+        STDMETHOD(SetTimestretchSettings)(UINT32 uTimestretchMethod) = 0;
+        STDMETHOD_(void, GetTimestretchSettings)(UINT32* puTimestretchMethod) = 0;
+    };
+    _COM_SMARTPTR_TYPEDEF(ISettings, __uuidof(ISettings));
+
+    struct __declspec(uuid("6B0D9E42-3F1A-4C58-B7E2-9A14C05D83F6"))
+    ISettings2 : ISettings
+    {
+        enum
+        {
+            HEADLESS_DEVICE_NONE = 0,
+            HEADLESS_DEVICE_NULL = 1,
+            HEADLESS_DEVICE_FILE = 2,
+            HEADLESS_DEVICE_SIMULATED = 3,
+            HEADLESS_DEVICE_SPEED_UNLIMITED = 0,
+            HEADLESS_DEVICE_SPEED_REALTIME = 100,
+            HEADLESS_DEVICE_SPEED_MAX = 10000,
+        };
+        STDMETHOD(SetHeadlessDevice)(UINT32 uDevice, LPCWSTR pFilePath, UINT32 uSpeedPercent) = 0;
+        STDMETHOD(GetHeadlessDevice)(UINT32* puDevice, LPWSTR* ppFilePath, UINT32* puSpeedPercent) = 0;
+
+        enum
+        {
+            SIMULATED_DEVICE_PERIOD_MIN_US = 1000,
+            SIMULATED_DEVICE_PERIOD_MAX_US = 100000,
+            SIMULATED_DEVICE_PERIOD_DEFAULT_US = 10000,
+            SIMULATED_DEVICE_DRIFT_MAX_PPM = 10000,
+        };
+        STDMETHOD(SetSimulatedDeviceSettings)(UINT32 uPeriodUs, INT32 iDriftPpm,
+                                              UINT32 uPositionJitterUs, UINT32 uEventJitterUs) = 0;
+        STDMETHOD_(void, GetSimulatedDeviceSettings)(UINT32* puPeriodUs, INT32* piDriftPpm,
+                                                     UINT32* puPositionJitterUs, UINT32* puEventJitterUs) = 0;
+
+        STDMETHOD_(void, SetExclusivePauseSilence)(BOOL bEnable) = 0;
+        STDMETHOD_(BOOL, GetExclusivePauseSilence)() = 0;
+
+        STDMETHOD_(void, SetAdaptiveBuffer)(BOOL bEnable) = 0;
+        STDMETHOD_(BOOL, GetAdaptiveBuffer)() = 0;
+
+        enum
+        {
+            LOW_LATENCY_PERIOD_OFF = 0,
+            LOW_LATENCY_PERIOD_MIN_US = 1000,
+            LOW_LATENCY_PERIOD_MAX_US = 20000,
+        };
+        STDMETHOD(SetLowLatencyPeriod)(UINT32 uPeriodUs) = 0;
+        STDMETHOD_(UINT32, GetLowLatencyPeriod)() = 0;
+
+        STDMETHOD_(void, SetPullMode)(BOOL bEnable) = 0;
+        STDMETHOD_(BOOL, GetPullMode)() = 0;
+
+        enum
+        {
+            LIVE_TARGET_LATENCY_AUTO = 0,
+            LIVE_TARGET_LATENCY_MIN_MS = 5,
+            LIVE_TARGET_LATENCY_MAX_MS = 1000,
+        };
+        STDMETHOD(SetLiveTargetLatency)(UINT32 uLatencyMs) = 0;
+        STDMETHOD_(UINT32, GetLiveTargetLatency)() = 0;
+
+        enum
+        {
+            START_PREBUFFER_FULL = 0,
+            START_PREBUFFER_MIN_PERIODS = 2,
+            START_PREBUFFER_MAX_PERIODS = 32,
+        };
+        STDMETHOD(SetStartPrebuffer)(UINT32 uPeriods) = 0;
+        STDMETHOD_(UINT32, GetStartPrebuffer)() = 0;
+    };
+    _COM_SMARTPTR_TYPEDEF(ISettings2, __uuidof(ISettings2));
+
+    struct __declspec(uuid("03481710-D73E-4674-839F-03EDE2D60ED8"))
+    ISpecifyPropertyPages2 : ISpecifyPropertyPages
+    {
+        STDMETHOD(CreatePage)(const GUID& guid, IPropertyPage** ppPage) = 0;
+    };
+    _COM_SMARTPTR_TYPEDEF(ISpecifyPropertyPages2, __uuidof(ISpecifyPropertyPages2));
+}
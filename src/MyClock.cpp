@@ -1,217 +1,414 @@
-#include "pch.h"
-#include "MyClock.h"
-
-#include "AudioRenderer.h"
-
-namespace SaneAudioRenderer
-{
-    MyClock::MyClock(IUnknown* pUnknown, const std::unique_ptr<AudioRenderer>& renderer, HRESULT& result)
-        : CBaseReferenceClock(L"SaneAudioRenderer::MyClock", pUnknown, &result)
-        , m_renderer(renderer)
-        , m_performanceFrequency(GetPerformanceFrequency())
-    {
-    }
-
-    STDMETHODIMP MyClock::NonDelegatingQueryInterface(REFIID riid, void** ppv)
-    {
-        if (riid == __uuidof(IGuidedReclock))
-            return GetInterface(static_cast<IGuidedReclock*>(this), ppv);
-
-        return CBaseReferenceClock::NonDelegatingQueryInterface(riid, ppv);
-    }
-
-    REFERENCE_TIME MyClock::GetPrivateTime()
-    {
-        CAutoLock lock(this);
-
-    #ifndef NDEBUG
-        const int64_t oldCounterOffset = m_counterOffset;
-    #endif
-
-        if (m_guidedReclockSlaving && !CanDoGuidedReclock())
-            UnslaveClock();
-
-        REFERENCE_TIME audioClockTime, counterTime, clockTime;
-
-        if (m_guidedReclockSlaving)
-        {
-            auto getGuidedReclockTime = [this](int64_t counterTime)
-            {
-                int64_t progress = (int64_t)((counterTime - m_guidedReclockStartTime) * m_guidedReclockMultiplier);
-                return m_guidedReclockStartClock + progress;
-            };
-
-            if (SUCCEEDED(GetAudioClockTime(&audioClockTime, &counterTime)))
-            {
-                clockTime = getGuidedReclockTime(counterTime);
-                int64_t diff = clockTime - audioClockTime;
-                m_audioOffset += diff;
-                m_renderer->TakeGuidedReclock(diff);
-            }
-            else
-            {
-                counterTime = GetCounterTime();
-                clockTime = getGuidedReclockTime(counterTime);
-            }
-
-            m_counterOffset = clockTime - counterTime;
-        }
-        else if (SUCCEEDED(GetAudioClockTime(&audioClockTime, &counterTime)))
-        {
-            clockTime = audioClockTime;
-            m_counterOffset = audioClockTime - counterTime;
-        }
-        else
-        {
-            clockTime = m_counterOffset + GetCounterTime();
-        }
-
-    #ifndef NDEBUG
-        int64_t counterOffsetDiff = m_counterOffset - oldCounterOffset;
-        if (std::abs(counterOffsetDiff) > OneMillisecond / 2)
-            DebugOut(ClassName(this), "observed clock warp of", counterOffsetDiff / 10000., "ms");
-    #endif
-
-        return clockTime;
-    }
-
-    void MyClock::SlaveClockToAudio(IAudioClock* pAudioClock, int64_t audioStart)
-    {
-        assert(pAudioClock);
-
-        CAutoLock lock(this);
-
-        DebugOut(ClassName(this), "slave clock to audio device (delayed until it progresses)");
-
-        m_audioClock = pAudioClock;
-        m_audioStart = audioStart;
-        m_audioInitialPosition = 0;
-        m_audioClock->GetPosition(&m_audioInitialPosition, nullptr);
-        m_audioOffset = 0;
-    }
-
-    void MyClock::UnslaveClockFromAudio()
-    {
-        CAutoLock lock(this);
-
-        DebugOut(ClassName(this), "unslave clock from audio device");
-
-        m_audioClock = nullptr;
-    }
-
-    void MyClock::OffsetAudioClock(REFERENCE_TIME offsetTime)
-    {
-        CAutoLock lock(this);
-
-        m_audioOffset += offsetTime;
-    }
-
-    HRESULT MyClock::GetAudioClockTime(REFERENCE_TIME* pAudioTime, REFERENCE_TIME* pCounterTime)
-    {
-        CheckPointer(pAudioTime, E_POINTER);
-
-        CAutoLock lock(this);
-
-        if (m_audioClock)
-        {
-            uint64_t audioFrequency, audioPosition, audioTime;
-            if (SUCCEEDED(m_audioClock->GetFrequency(&audioFrequency)) &&
-                SUCCEEDED(m_audioClock->GetPosition(&audioPosition, &audioTime)) &&
-                audioPosition > m_audioInitialPosition)
-            {
-                int64_t counterTime = GetCounterTime();
-                int64_t clockTime = llMulDiv(audioPosition, OneSecond, audioFrequency, 0) +
-                                    m_audioStart + m_audioOffset + counterTime - audioTime;
-
-                *pAudioTime = clockTime;
-
-                if (pCounterTime)
-                    *pCounterTime = counterTime;
-
-                return S_OK;
-            }
-
-            return E_FAIL;
-        }
-
-        return E_FAIL;
-    }
-
-    HRESULT MyClock::GetAudioClockStartTime(REFERENCE_TIME* pStartTime)
-    {
-        CheckPointer(pStartTime, E_POINTER);
-
-        CAutoLock lock(this);
-
-        if (m_audioClock)
-        {
-            *pStartTime = m_audioStart;
-            return S_OK;
-        }
-
-        return E_FAIL;
-    }
-
-    STDMETHODIMP MyClock::SlaveClock(DOUBLE multiplier)
-    {
-        CAutoLock lock(this);
-
-        if (!CanDoGuidedReclock())
-            return E_FAIL;
-
-        int64_t time;
-        ReturnIfFailed(GetTime(&time));
-
-        m_guidedReclockSlaving = true;
-        m_guidedReclockMultiplier = multiplier;
-        m_guidedReclockStartTime = GetCounterTime();
-        m_guidedReclockStartClock = time;
-
-        return S_OK;
-    }
-
-    STDMETHODIMP MyClock::UnslaveClock()
-    {
-        CAutoLock lock(this);
-
-        if (!m_guidedReclockSlaving)
-            return S_FALSE;
-
-        GetPrivateTime();
-        m_guidedReclockSlaving = false;
-
-        return S_OK;
-    }
-
-    STDMETHODIMP MyClock::OffsetClock(LONGLONG offset)
-    {
-        CAutoLock lock(this);
-
-        if (!CanDoGuidedReclock())
-            return E_FAIL;
-
-        m_audioOffset += offset;
-        m_counterOffset += offset;
-        m_guidedReclockStartClock += offset;
-
-        m_renderer->TakeGuidedReclock(offset);
-
-        return S_OK;
-    }
-
-    STDMETHODIMP MyClock::GetImmediateTime(LONGLONG* pTime)
-    {
-        CheckPointer(pTime, E_POINTER);
-
-        *pTime = GetPrivateTime();
-
-        return S_OK;
-    }
-
-    bool MyClock::CanDoGuidedReclock()
-    {
-        return !m_renderer->IsBitstreaming() &&
-               !m_renderer->OnExternalClock() &&
-               !m_renderer->IsLive();
-    }
-}
+#include "pch.h"
+#include "MyClock.h"
+
+#include "AudioRenderer.h"
+
+namespace SaneAudioRenderer
+{
+    MyClock::MyClock(IUnknown* pUnknown, const std::unique_ptr<AudioRenderer>& renderer, HRESULT& result)
+        : CBaseReferenceClock(L"SaneAudioRenderer::MyClock", pUnknown, &result)
+        , m_renderer(renderer)
+        , m_performanceFrequency(GetPerformanceFrequency())
+        , m_adviser([this] { return GetPrivateTime(); }, result)
+    {
+    }
+
+    STDMETHODIMP MyClock::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == __uuidof(IGuidedReclock) || riid == __uuidof(IGuidedReclock2))
+            return GetInterface(static_cast<IGuidedReclock2*>(this), ppv);
+
+        if (riid == __uuidof(IClockDrift))
+            return GetInterface(static_cast<IClockDrift*>(this), ppv);
+
+        if (riid == __uuidof(IClockStats))
+            return GetInterface(static_cast<IClockStats*>(this), ppv);
+
+        return CBaseReferenceClock::NonDelegatingQueryInterface(riid, ppv);
+    }
+
+    STDMETHODIMP MyClock::GetTime(REFERENCE_TIME* pTime)
+    {
+        CheckPointer(pTime, E_POINTER);
+
+        // Same as the base class, minus the locking.
+        const REFERENCE_TIME time = GetPrivateTime();
+
+        REFERENCE_TIME lastTime = m_lastGotTime;
+        while (time > lastTime)
+        {
+            if (m_lastGotTime.compare_exchange_weak(lastTime, time))
+            {
+                *pTime = time;
+                return S_OK;
+            }
+        }
+
+        *pTime = lastTime;
+        return S_FALSE;
+    }
+
+    STDMETHODIMP MyClock::AdviseTime(REFERENCE_TIME baseTime, REFERENCE_TIME streamTime,
+                                     HEVENT hEvent, DWORD_PTR* pdwAdviseCookie)
+    {
+        CheckPointer(pdwAdviseCookie, E_POINTER);
+        *pdwAdviseCookie = 0;
+
+        if (baseTime < 0 || streamTime < 0 || baseTime > INT64_MAX - streamTime)
+            return E_INVALIDARG;
+
+        return m_adviser.AdviseTime(baseTime + streamTime, reinterpret_cast<HANDLE>(hEvent), pdwAdviseCookie);
+    }
+
+    STDMETHODIMP MyClock::AdvisePeriodic(REFERENCE_TIME startTime, REFERENCE_TIME periodTime,
+                                         HSEMAPHORE hSemaphore, DWORD_PTR* pdwAdviseCookie)
+    {
+        CheckPointer(pdwAdviseCookie, E_POINTER);
+        *pdwAdviseCookie = 0;
+
+        return m_adviser.AdvisePeriodic(startTime, periodTime, reinterpret_cast<HANDLE>(hSemaphore), pdwAdviseCookie);
+    }
+
+    STDMETHODIMP MyClock::Unadvise(DWORD_PTR dwAdviseCookie)
+    {
+        return m_adviser.Unadvise(dwAdviseCookie);
+    }
+
+    REFERENCE_TIME MyClock::GetPrivateTime()
+    {
+        REFERENCE_TIME clockTime;
+        if (ReadAnchor(GetCounterTime(), clockTime))
+            return clockTime;
+
+        CAutoLock lock(this);
+
+        return UpdatePrivateTime();
+    }
+
+    REFERENCE_TIME MyClock::UpdatePrivateTime()
+    {
+        CAutoLock lock(this);
+
+        const int64_t oldCounterOffset = m_counterOffset;
+
+        if (m_guidedReclockSlaving && !CanDoGuidedReclock())
+            UnslaveClock();
+
+        REFERENCE_TIME audioClockTime, counterTime, clockTime;
+
+        if (m_guidedReclockSlaving)
+        {
+            auto getGuidedReclockTime = [this](int64_t counterTime)
+            {
+                int64_t progress = (int64_t)((counterTime - m_guidedReclockStartTime) * m_guidedReclockMultiplier);
+                return m_guidedReclockStartClock + progress;
+            };
+
+            if (SUCCEEDED(GetAudioClockTime(&audioClockTime, &counterTime)))
+            {
+                clockTime = getGuidedReclockTime(counterTime);
+                int64_t diff = clockTime - audioClockTime;
+                m_audioOffset += diff;
+                m_renderer->TakeGuidedReclock(diff);
+            }
+            else
+            {
+                counterTime = GetCounterTime();
+                clockTime = getGuidedReclockTime(counterTime);
+            }
+
+            m_counterOffset = clockTime - counterTime;
+        }
+        else if (SUCCEEDED(GetAudioClockTime(&audioClockTime, &counterTime)))
+        {
+            clockTime = audioClockTime;
+            m_counterOffset = audioClockTime - counterTime;
+        }
+        else
+        {
+            clockTime = m_counterOffset + GetCounterTime();
+        }
+
+        const int64_t counterOffsetDiff = m_counterOffset - oldCounterOffset;
+
+        if (std::abs(counterOffsetDiff) > 100)
+            m_stats.Record(CLOCK_STATS_WARP, counterOffsetDiff);
+
+        if (std::abs(counterOffsetDiff) > OneMillisecond / 2)
+            DebugOut(ClassName(this), "observed clock warp of", counterOffsetDiff / 10000., "ms");
+
+        PublishAnchor(clockTime - m_counterOffset, clockTime, m_guidedReclockSlaving ? m_guidedReclockMultiplier : 1.0);
+
+        return clockTime;
+    }
+
+    void MyClock::SlaveClockToAudio(IAudioClock* pAudioClock, int64_t audioStart)
+    {
+        assert(pAudioClock);
+
+        CAutoLock lock(this);
+
+        DebugOut(ClassName(this), "slave clock to audio device (delayed until it progresses)");
+
+        m_audioClock = pAudioClock;
+        m_audioFrequency = 0;
+        m_audioClock->GetFrequency(&m_audioFrequency);
+        m_audioClockModel.Reset();
+        m_driftEstimator.Rebase();
+        m_audioStart = audioStart;
+        m_audioInitialPosition = 0;
+        m_audioClock->GetPosition(&m_audioInitialPosition, nullptr);
+        m_audioOffset = 0;
+
+        InvalidateAnchor();
+    }
+
+    void MyClock::UnslaveClockFromAudio()
+    {
+        CAutoLock lock(this);
+
+        DebugOut(ClassName(this), "unslave clock from audio device");
+
+        m_audioClock = nullptr;
+
+        InvalidateAnchor();
+    }
+
+    void MyClock::OffsetAudioClock(REFERENCE_TIME offsetTime)
+    {
+        CAutoLock lock(this);
+
+        m_audioOffset += offsetTime;
+
+        InvalidateAnchor();
+    }
+
+    HRESULT MyClock::GetAudioClockTime(REFERENCE_TIME* pAudioTime, REFERENCE_TIME* pCounterTime)
+    {
+        CheckPointer(pAudioTime, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (m_audioClock && m_audioFrequency > 0)
+        {
+            const int64_t counterTime = GetCounterTime();
+
+            // The driver is queried at a limited rate, the model interpolates in between.
+            if (m_audioClockModel.ShouldSample(counterTime))
+            {
+                uint64_t audioPosition, audioTime;
+                if (SUCCEEDED(m_audioClock->GetPosition(&audioPosition, &audioTime)) &&
+                    audioPosition > m_audioInitialPosition)
+                {
+                    const int64_t positionTime = llMulDiv(audioPosition, OneSecond, m_audioFrequency, 0);
+
+                    if (!m_audioClockModel.AddSample(audioTime, positionTime))
+                        m_driftEstimator.Rebase();
+
+                    m_driftEstimator.AddSample(audioTime, positionTime);
+                }
+            }
+
+            int64_t positionTime;
+            if (m_audioClockModel.Predict(counterTime, positionTime))
+            {
+                *pAudioTime = positionTime + m_audioStart + m_audioOffset;
+
+                if (pCounterTime)
+                    *pCounterTime = counterTime;
+
+                return S_OK;
+            }
+
+            return E_FAIL;
+        }
+
+        return E_FAIL;
+    }
+
+    HRESULT MyClock::GetAudioClockStartTime(REFERENCE_TIME* pStartTime)
+    {
+        CheckPointer(pStartTime, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (m_audioClock)
+        {
+            *pStartTime = m_audioStart;
+            return S_OK;
+        }
+
+        return E_FAIL;
+    }
+
+    STDMETHODIMP MyClock::SlaveClock(DOUBLE multiplier)
+    {
+        CAutoLock lock(this);
+
+        if (!CanDoGuidedReclock())
+            return E_FAIL;
+
+        int64_t time;
+        ReturnIfFailed(GetTime(&time));
+
+        m_guidedReclockSlaving = true;
+        m_guidedReclockMultiplier = multiplier;
+        m_guidedReclockStartTime = GetCounterTime();
+        m_guidedReclockStartClock = time;
+
+        InvalidateAnchor();
+
+        return S_OK;
+    }
+
+    STDMETHODIMP MyClock::UnslaveClock()
+    {
+        CAutoLock lock(this);
+
+        if (!m_guidedReclockSlaving)
+            return S_FALSE;
+
+        UpdatePrivateTime();
+        m_guidedReclockSlaving = false;
+
+        InvalidateAnchor();
+
+        return S_OK;
+    }
+
+    STDMETHODIMP MyClock::OffsetClock(LONGLONG offset)
+    {
+        CAutoLock lock(this);
+
+        if (!CanDoGuidedReclock())
+            return E_FAIL;
+
+        m_audioOffset += offset;
+        m_counterOffset += offset;
+        m_guidedReclockStartClock += offset;
+
+        InvalidateAnchor();
+
+        m_renderer->TakeGuidedReclock(offset);
+
+        return S_OK;
+    }
+
+    STDMETHODIMP MyClock::GetImmediateTime(LONGLONG* pTime)
+    {
+        CheckPointer(pTime, E_POINTER);
+
+        *pTime = GetPrivateTime();
+
+        return S_OK;
+    }
+
+    STDMETHODIMP MyClock::GetResidualError(LONGLONG* pError)
+    {
+        CheckPointer(pError, E_POINTER);
+
+        // Renderer lock is taken before ours elsewhere, so not holding ours here.
+        if (!CanDoGuidedReclock())
+            return E_FAIL;
+
+        *pError = m_renderer->GetGuidedReclockResidual();
+
+        return S_OK;
+    }
+
+    STDMETHODIMP MyClock::GetClockDrift(DOUBLE* pDriftPpm, DOUBLE* pErrorPpm)
+    {
+        CheckPointer(pDriftPpm, E_POINTER);
+        CheckPointer(pErrorPpm, E_POINTER);
+
+        CAutoLock lock(this);
+
+        double driftPpm, errorPpm;
+        if (!m_driftEstimator.GetDrift(driftPpm, errorPpm))
+            return E_FAIL;
+
+        *pDriftPpm = driftPpm;
+        *pErrorPpm = errorPpm;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP MyClock::GetClockStats(UINT32 uKind, UINT64* pEvents, LONGLONG* pTotalTime, LONGLONG* pMaxTime,
+                                        UINT64* pBins)
+    {
+        return m_stats.Get(uKind, pEvents, pTotalTime, pMaxTime, pBins);
+    }
+
+    STDMETHODIMP MyClock::ResetClockStats()
+    {
+        m_stats.Reset();
+
+        return S_OK;
+    }
+
+    bool MyClock::CanDoGuidedReclock()
+    {
+        return !m_renderer->IsBitstreaming() &&
+               !m_renderer->OnExternalClock() &&
+               !m_renderer->IsLive();
+    }
+
+    bool MyClock::ReadAnchor(int64_t counterTime, REFERENCE_TIME& clockTime)
+    {
+        const uint32_t sequence = m_anchorSequence.load(std::memory_order_acquire);
+
+        // Odd sequence means the anchor is being rewritten, the locked path will have the fresh one.
+        if (sequence & 1)
+            return false;
+
+        const bool valid = m_anchorValid.load(std::memory_order_relaxed);
+        const int64_t anchorCounterTime = m_anchorCounterTime.load(std::memory_order_relaxed);
+        const int64_t anchorClockTime = m_anchorClockTime.load(std::memory_order_relaxed);
+        const double anchorRate = m_anchorRate.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (m_anchorSequence.load(std::memory_order_relaxed) != sequence)
+            return false;
+
+        // Extrapolating for longer would let audio device drift creep in.
+        const int64_t elapsed = counterTime - anchorCounterTime;
+        if (!valid || elapsed < 0 || elapsed > 2 * OneMillisecond)
+            return false;
+
+        clockTime = anchorClockTime + (int64_t)(elapsed * anchorRate);
+
+        return true;
+    }
+
+    void MyClock::PublishAnchor(int64_t counterTime, REFERENCE_TIME clockTime, double rate)
+    {
+        CAutoLock lock(this);
+
+        const uint32_t sequence = m_anchorSequence.load(std::memory_order_relaxed);
+        m_anchorSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_anchorValid.store(true, std::memory_order_relaxed);
+        m_anchorCounterTime.store(counterTime, std::memory_order_relaxed);
+        m_anchorClockTime.store(clockTime, std::memory_order_relaxed);
+        m_anchorRate.store(rate, std::memory_order_relaxed);
+
+        m_anchorSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void MyClock::InvalidateAnchor()
+    {
+        CAutoLock lock(this);
+
+        const uint32_t sequence = m_anchorSequence.load(std::memory_order_relaxed);
+        m_anchorSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_anchorValid.store(false, std::memory_order_relaxed);
+
+        m_anchorSequence.store(sequence + 2, std::memory_order_release);
+
+        m_adviser.ClockChanged();
+    }
+}
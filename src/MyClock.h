@@ -1,57 +1,106 @@
-#pragma once
-
-#include "../IGuidedReclock.h"
-
-namespace SaneAudioRenderer
-{
-    class AudioRenderer;
-
-    class MyClock final
-        : public CBaseReferenceClock
-        , public IGuidedReclock
-    {
-    public:
-
-        MyClock(IUnknown* pUnknown, const std::unique_ptr<AudioRenderer>& renderer, HRESULT& result);
-        MyClock(const MyClock&) = delete;
-        MyClock& operator=(const MyClock&) = delete;
-
-        DECLARE_IUNKNOWN
-
-        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
-
-        REFERENCE_TIME GetPrivateTime() override;
-
-        void SlaveClockToAudio(IAudioClock* pAudioClock, int64_t audioStart);
-        void UnslaveClockFromAudio();
-        void OffsetAudioClock(REFERENCE_TIME offsetTime);
-        HRESULT GetAudioClockTime(REFERENCE_TIME* pAudioTime, REFERENCE_TIME* pCounterTime);
-        HRESULT GetAudioClockStartTime(REFERENCE_TIME* pStartTime);
-
-        STDMETHODIMP SlaveClock(DOUBLE multiplier) override;
-        STDMETHODIMP UnslaveClock() override;
-        STDMETHODIMP OffsetClock(LONGLONG offset) override;
-        STDMETHODIMP GetImmediateTime(LONGLONG* pTime) override;
-
-    private:
-
-        bool CanDoGuidedReclock();
-
-        int64_t GetCounterTime() { return llMulDiv(GetPerformanceCounter(), OneSecond, m_performanceFrequency, 0); }
-
-        const std::unique_ptr<AudioRenderer>& m_renderer;
-
-        const int64_t m_performanceFrequency;
-
-        IAudioClockPtr m_audioClock;
-        int64_t m_audioStart = 0;
-        uint64_t m_audioInitialPosition = 0;
-        int64_t m_audioOffset = 0;
-        int64_t m_counterOffset = 0;
-
-        bool m_guidedReclockSlaving = false;
-        double m_guidedReclockMultiplier = 1.0;
-        int64_t m_guidedReclockStartTime = 0;
-        int64_t m_guidedReclockStartClock = 0;
-    };
-}
+#pragma once
+
+#include "../IClockDrift.h"
+#include "../IClockStats.h"
+#include "../IGuidedReclock.h"
+
+#include "AdviseScheduler.h"
+#include "AudioClockModel.h"
+#include "ClockDriftEstimator.h"
+#include "ClockStats.h"
+
+namespace SaneAudioRenderer
+{
+    class AudioRenderer;
+
+    class MyClock final
+        : public CBaseReferenceClock
+        , public IGuidedReclock2
+        , public IClockDrift
+        , public IClockStats
+    {
+    public:
+
+        MyClock(IUnknown* pUnknown, const std::unique_ptr<AudioRenderer>& renderer, HRESULT& result);
+        MyClock(const MyClock&) = delete;
+        MyClock& operator=(const MyClock&) = delete;
+
+        DECLARE_IUNKNOWN
+
+        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
+
+        STDMETHODIMP GetTime(REFERENCE_TIME* pTime) override;
+
+        STDMETHODIMP AdviseTime(REFERENCE_TIME baseTime, REFERENCE_TIME streamTime,
+                                HEVENT hEvent, DWORD_PTR* pdwAdviseCookie) override;
+        STDMETHODIMP AdvisePeriodic(REFERENCE_TIME startTime, REFERENCE_TIME periodTime,
+                                    HSEMAPHORE hSemaphore, DWORD_PTR* pdwAdviseCookie) override;
+        STDMETHODIMP Unadvise(DWORD_PTR dwAdviseCookie) override;
+
+        REFERENCE_TIME GetPrivateTime() override;
+
+        void SlaveClockToAudio(IAudioClock* pAudioClock, int64_t audioStart);
+        void UnslaveClockFromAudio();
+        void OffsetAudioClock(REFERENCE_TIME offsetTime);
+        HRESULT GetAudioClockTime(REFERENCE_TIME* pAudioTime, REFERENCE_TIME* pCounterTime);
+        HRESULT GetAudioClockStartTime(REFERENCE_TIME* pStartTime);
+
+        STDMETHODIMP SlaveClock(DOUBLE multiplier) override;
+        STDMETHODIMP UnslaveClock() override;
+        STDMETHODIMP OffsetClock(LONGLONG offset) override;
+        STDMETHODIMP GetImmediateTime(LONGLONG* pTime) override;
+        STDMETHODIMP GetResidualError(LONGLONG* pError) override;
+
+        STDMETHODIMP GetClockDrift(DOUBLE* pDriftPpm, DOUBLE* pErrorPpm) override;
+
+        STDMETHODIMP GetClockStats(UINT32 uKind, UINT64* pEvents, LONGLONG* pTotalTime, LONGLONG* pMaxTime,
+                                   UINT64* pBins) override;
+        STDMETHODIMP ResetClockStats() override;
+
+        ClockStats& GetStats() { return m_stats; }
+
+    private:
+
+        bool CanDoGuidedReclock();
+
+        REFERENCE_TIME UpdatePrivateTime();
+
+        bool ReadAnchor(int64_t counterTime, REFERENCE_TIME& clockTime);
+        void PublishAnchor(int64_t counterTime, REFERENCE_TIME clockTime, double rate);
+        void InvalidateAnchor();
+
+        int64_t GetCounterTime() { return llMulDiv(GetPerformanceCounter(), OneSecond, m_performanceFrequency, 0); }
+
+        const std::unique_ptr<AudioRenderer>& m_renderer;
+
+        const int64_t m_performanceFrequency;
+
+        IAudioClockPtr m_audioClock;
+        uint64_t m_audioFrequency = 0;
+        AudioClockModel m_audioClockModel;
+        ClockDriftEstimator m_driftEstimator;
+        ClockStats m_stats;
+        int64_t m_audioStart = 0;
+        uint64_t m_audioInitialPosition = 0;
+        int64_t m_audioOffset = 0;
+        int64_t m_counterOffset = 0;
+
+        bool m_guidedReclockSlaving = false;
+        double m_guidedReclockMultiplier = 1.0;
+        int64_t m_guidedReclockStartTime = 0;
+        int64_t m_guidedReclockStartClock = 0;
+
+        // Clock state published under a sequence lock, readers extrapolate from it without locking
+        // for a short while. Written only with the object lock held.
+        std::atomic<uint32_t> m_anchorSequence = 0;
+        std::atomic<bool> m_anchorValid = false;
+        std::atomic<int64_t> m_anchorCounterTime = 0;
+        std::atomic<int64_t> m_anchorClockTime = 0;
+        std::atomic<double> m_anchorRate = 1.0;
+
+        std::atomic<REFERENCE_TIME> m_lastGotTime = 0;
+
+        // Last member, its thread reads the clock until it's destroyed.
+        AdviseScheduler m_adviser;
+    };
+}
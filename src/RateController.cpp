@@ -0,0 +1,26 @@
+#include "pch.h"
+#include "RateController.h"
+
+namespace SaneAudioRenderer
+{
+    namespace
+    {
+        // The error is worked off over this time, as long as it stays within the deviation bound.
+        const double CorrectionTime = 4.0 * OneSecond;
+
+        // About 17 cents, keeps the pitch shift from getting objectionable.
+        const double MaxDeviation = 0.01;
+
+        // Low-pass on the deviation itself, so that jittery error input doesn't modulate the pitch.
+        const double SmoothingTime = 0.5 * OneSecond;
+    }
+
+    double RateController::Update(REFERENCE_TIME error, REFERENCE_TIME duration)
+    {
+        const double target = std::min(MaxDeviation, std::max(-MaxDeviation, error / CorrectionTime));
+
+        m_deviation += (target - m_deviation) * std::min(1.0, duration / SmoothingTime);
+
+        return m_deviation;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // Turns the remaining time adjustment into a smooth and bounded resampling rate deviation.
+    class RateController final
+    {
+    public:
+
+        RateController() = default;
+        RateController(const RateController&) = delete;
+        RateController& operator=(const RateController&) = delete;
+
+        void Reset() { m_deviation = 0.0; }
+
+        // Positive error - more samples are needed. Returns relative deviation of the output rate.
+        double Update(REFERENCE_TIME error, REFERENCE_TIME duration);
+
+        double GetDeviation() const { return m_deviation; }
+
+    private:
+
+        double m_deviation = 0.0;
+    };
+}
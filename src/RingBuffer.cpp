@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "RingBuffer.h"
+
+namespace SaneAudioRenderer
+{
+    void RingBuffer::Initialize(size_t frames, uint32_t frameSize)
+    {
+        assert(frames > 0);
+        assert(frameSize > 0);
+
+        m_data.reset((char*)_aligned_malloc(frames * frameSize, 16));
+
+        if (!m_data.get())
+            throw std::bad_alloc();
+
+        m_capacity = frames;
+        m_frameSize = frameSize;
+
+        Reset();
+    }
+
+    void RingBuffer::Reset()
+    {
+        m_writePosition = 0;
+        m_readPosition = 0;
+    }
+
+    size_t RingBuffer::GetReadable() const
+    {
+        const uint64_t readPosition = m_readPosition.load(std::memory_order_acquire);
+        const uint64_t writePosition = m_writePosition.load(std::memory_order_acquire);
+        assert(writePosition >= readPosition);
+
+        return (size_t)(writePosition - readPosition);
+    }
+
+    size_t RingBuffer::GetWritable() const
+    {
+        return m_capacity - GetReadable();
+    }
+
+    size_t RingBuffer::Write(const char* pData, size_t frames)
+    {
+        assert(pData || frames == 0);
+
+        frames = std::min(frames, GetWritable());
+
+        if (frames == 0)
+            return 0;
+
+        const uint64_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+        const size_t offset = (size_t)(writePosition % m_capacity);
+        const size_t firstFrames = std::min(frames, m_capacity - offset);
+
+        memcpy(m_data.get() + offset * m_frameSize, pData, firstFrames * m_frameSize);
+        memcpy(m_data.get(), pData + firstFrames * m_frameSize, (frames - firstFrames) * m_frameSize);
+
+        m_writePosition.store(writePosition + frames, std::memory_order_release);
+
+        return frames;
+    }
+
+    size_t RingBuffer::Read(char* pData, size_t frames)
+    {
+        assert(pData || frames == 0);
+
+        frames = std::min(frames, GetReadable());
+
+        if (frames == 0)
+            return 0;
+
+        const uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+        const size_t offset = (size_t)(readPosition % m_capacity);
+        const size_t firstFrames = std::min(frames, m_capacity - offset);
+
+        memcpy(pData, m_data.get() + offset * m_frameSize, firstFrames * m_frameSize);
+        memcpy(pData + firstFrames * m_frameSize, m_data.get(), (frames - firstFrames) * m_frameSize);
+
+        m_readPosition.store(readPosition + frames, std::memory_order_release);
+
+        return frames;
+    }
+
+    size_t RingBuffer::Skip(size_t frames)
+    {
+        frames = std::min(frames, GetReadable());
+
+        m_readPosition.store(m_readPosition.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+
+        return frames;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // Wait-free single producer single consumer queue of fixed size frames.
+    class RingBuffer final
+    {
+    public:
+
+        RingBuffer() = default;
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        void Initialize(size_t frames, uint32_t frameSize);
+        void Reset();
+
+        size_t GetCapacity()   const { return m_capacity; }
+        uint32_t GetFrameSize() const { return m_frameSize; }
+
+        size_t GetReadable() const;
+        size_t GetWritable() const;
+
+        // Producer side.
+        size_t Write(const char* pData, size_t frames);
+
+        // Consumer side.
+        size_t Read(char* pData, size_t frames);
+        size_t Skip(size_t frames);
+
+    private:
+
+        std::unique_ptr<char[], AlignedFreeDeleter> m_data;
+        size_t m_capacity = 0;
+        uint32_t m_frameSize = 0;
+
+        std::atomic<uint64_t> m_writePosition = 0;
+        std::atomic<uint64_t> m_readPosition = 0;
+    };
+}
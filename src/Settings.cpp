@@ -1,195 +1,443 @@
-#include "pch.h"
-#include "Settings.h"
-
-namespace SaneAudioRenderer
-{
-    Settings::Settings(IUnknown* pUnknown)
-        : CUnknown("Audio Renderer Settings", pUnknown)
-    {
-    }
-
-    STDMETHODIMP Settings::NonDelegatingQueryInterface(REFIID riid, void** ppv)
-    {
-        return (riid == __uuidof(ISettings)) ?
-                   GetInterface(static_cast<ISettings*>(this), ppv) :
-                   CUnknown::NonDelegatingQueryInterface(riid, ppv);
-    }
-
-    STDMETHODIMP_(UINT32) Settings::GetSerial()
-    {
-        return m_serial;
-    }
-
-    STDMETHODIMP Settings::SetOuputDevice(LPCWSTR pDeviceId, BOOL bExclusive, UINT32 uBufferMS)
-    {
-        if (uBufferMS < OUTPUT_DEVICE_BUFFER_MIN_MS || uBufferMS > OUTPUT_DEVICE_BUFFER_MAX_MS)
-            return E_INVALIDARG;
-
-        CAutoLock lock(this);
-
-        if (m_exclusive != bExclusive ||
-            m_buffer != uBufferMS ||
-            (pDeviceId && m_deviceId != pDeviceId) ||
-            (!pDeviceId && !m_deviceId.empty()))
-        {
-            try
-            {
-                m_deviceId = pDeviceId ? pDeviceId : L"";
-                m_exclusive = bExclusive;
-                m_buffer = uBufferMS;
-                m_serial++;
-            }
-            catch (std::bad_alloc&)
-            {
-                return E_OUTOFMEMORY;
-            }
-        }
-
-        return S_OK;
-    }
-
-    STDMETHODIMP Settings::GetOuputDevice(LPWSTR* ppDeviceId, BOOL* pbExclusive, UINT32* puBufferMS)
-    {
-        CAutoLock lock(this);
-
-        if (pbExclusive)
-            *pbExclusive = m_exclusive;
-
-        if (ppDeviceId)
-        {
-            size_t size = sizeof(wchar_t) * (m_deviceId.length() + 1);
-
-            *ppDeviceId = static_cast<LPWSTR>(CoTaskMemAlloc(size));
-
-            if (!*ppDeviceId)
-                return E_OUTOFMEMORY;
-
-            memcpy(*ppDeviceId, m_deviceId.c_str(), size);
-        }
-
-        if (puBufferMS)
-            *puBufferMS = m_buffer;
-
-        return S_OK;
-    }
-
-    STDMETHODIMP_(void) Settings::SetAllowBitstreaming(BOOL bAllowBitstreaming)
-    {
-        CAutoLock lock(this);
-
-        if (m_allowBitstreaming != bAllowBitstreaming)
-        {
-            m_allowBitstreaming = bAllowBitstreaming;
-            m_serial++;
-        }
-    }
-
-    STDMETHODIMP_(BOOL) Settings::GetAllowBitstreaming()
-    {
-        CAutoLock lock(this);
-
-        return m_allowBitstreaming;
-    }
-
-    STDMETHODIMP_(void) Settings::SetCrossfeedEnabled(BOOL bEnable)
-    {
-        CAutoLock lock(this);
-
-        if (m_crossfeedEnabled != bEnable)
-        {
-            m_crossfeedEnabled = bEnable;
-            m_serial++;
-        }
-    }
-
-    STDMETHODIMP_(BOOL) Settings::GetCrossfeedEnabled()
-    {
-        CAutoLock lock(this);
-
-        return m_crossfeedEnabled;
-    }
-
-    STDMETHODIMP Settings::SetCrossfeedSettings(UINT32 uCutoffFrequency, UINT32 uCrossfeedLevel)
-    {
-        if (uCutoffFrequency < CROSSFEED_CUTOFF_FREQ_MIN ||
-            uCutoffFrequency > CROSSFEED_CUTOFF_FREQ_MAX ||
-            uCrossfeedLevel < CROSSFEED_LEVEL_MIN ||
-            uCrossfeedLevel > CROSSFEED_LEVEL_MAX)
-        {
-            return E_INVALIDARG;
-        }
-
-        CAutoLock lock(this);
-
-        if (m_crossfeedCutoffFrequency != uCutoffFrequency ||
-            m_crossfeedLevel != uCrossfeedLevel)
-        {
-            m_crossfeedCutoffFrequency = uCutoffFrequency;
-            m_crossfeedLevel = uCrossfeedLevel;
-            m_serial++;
-        }
-
-        return S_OK;
-    }
-
-    STDMETHODIMP_(void) Settings::GetCrossfeedSettings(UINT32* puCutoffFrequency, UINT32* puCrossfeedLevel)
-    {
-        CAutoLock lock(this);
-
-        if (puCutoffFrequency)
-            *puCutoffFrequency = m_crossfeedCutoffFrequency;
-
-        if (puCrossfeedLevel)
-            *puCrossfeedLevel = m_crossfeedLevel;
-    }
-
-    STDMETHODIMP_(void) Settings::SetIgnoreSystemChannelMixer(BOOL bEnable)
-    {
-        CAutoLock lock(this);
-
-        if (m_ignoreSystemChannelMixer != bEnable)
-        {
-            m_ignoreSystemChannelMixer = bEnable;
-            m_serial++;
-        }
-    }
-
-    STDMETHODIMP_(BOOL) Settings::GetIgnoreSystemChannelMixer()
-    {
-        CAutoLock lock(this);
-
-        return m_ignoreSystemChannelMixer;
-    }
-
-    STDMETHODIMP Settings::SetTimestretchSettings(UINT32 uTimestretchMethod)
-    {
-        if (uTimestretchMethod != TIMESTRETCH_METHOD_SOLA &&
-            uTimestretchMethod != TIMESTRETCH_METHOD_PHASE_VOCODER)
-        {
-            return E_INVALIDARG;
-        }
-
-    #ifndef SANEAR_GPL_PHASE_VOCODER
-        if (uTimestretchMethod == TIMESTRETCH_METHOD_PHASE_VOCODER)
-            return E_NOTIMPL;
-    #endif
-
-        CAutoLock lock(this);
-
-        if (uTimestretchMethod != m_timestretchMethod)
-        {
-            m_timestretchMethod = uTimestretchMethod;
-            m_serial++;
-        }
-
-        return S_OK;
-    }
-
-    STDMETHODIMP_(void) Settings::GetTimestretchSettings(UINT32* puTimestretchMethod)
-    {
-        CAutoLock lock(this);
-
-        if (puTimestretchMethod)
-            *puTimestretchMethod = m_timestretchMethod;
-    }
-}
+#include "pch.h"
+#include "Settings.h"
+
+namespace SaneAudioRenderer
+{
+    Settings::Settings(IUnknown* pUnknown)
+        : CUnknown("Audio Renderer Settings", pUnknown)
+    {
+    }
+
+    STDMETHODIMP Settings::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == __uuidof(ISettings))
+            return GetInterface(static_cast<ISettings*>(this), ppv);
+
+        if (riid == __uuidof(ISettings2))
+            return GetInterface(static_cast<ISettings2*>(this), ppv);
+
+        return CUnknown::NonDelegatingQueryInterface(riid, ppv);
+    }
+
+    STDMETHODIMP_(UINT32) Settings::GetSerial()
+    {
+        return m_serial;
+    }
+
+    STDMETHODIMP Settings::SetOuputDevice(LPCWSTR pDeviceId, BOOL bExclusive, UINT32 uBufferMS)
+    {
+        if (uBufferMS < OUTPUT_DEVICE_BUFFER_MIN_MS || uBufferMS > OUTPUT_DEVICE_BUFFER_MAX_MS)
+            return E_INVALIDARG;
+
+        CAutoLock lock(this);
+
+        if (m_exclusive != bExclusive ||
+            m_buffer != uBufferMS ||
+            (pDeviceId && m_deviceId != pDeviceId) ||
+            (!pDeviceId && !m_deviceId.empty()))
+        {
+            try
+            {
+                m_deviceId = pDeviceId ? pDeviceId : L"";
+                m_exclusive = bExclusive;
+                m_buffer = uBufferMS;
+                m_serial++;
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP Settings::GetOuputDevice(LPWSTR* ppDeviceId, BOOL* pbExclusive, UINT32* puBufferMS)
+    {
+        CAutoLock lock(this);
+
+        if (pbExclusive)
+            *pbExclusive = m_exclusive;
+
+        if (ppDeviceId)
+        {
+            size_t size = sizeof(wchar_t) * (m_deviceId.length() + 1);
+
+            *ppDeviceId = static_cast<LPWSTR>(CoTaskMemAlloc(size));
+
+            if (!*ppDeviceId)
+                return E_OUTOFMEMORY;
+
+            memcpy(*ppDeviceId, m_deviceId.c_str(), size);
+        }
+
+        if (puBufferMS)
+            *puBufferMS = m_buffer;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(void) Settings::SetAllowBitstreaming(BOOL bAllowBitstreaming)
+    {
+        CAutoLock lock(this);
+
+        if (m_allowBitstreaming != bAllowBitstreaming)
+        {
+            m_allowBitstreaming = bAllowBitstreaming;
+            m_serial++;
+        }
+    }
+
+    STDMETHODIMP_(BOOL) Settings::GetAllowBitstreaming()
+    {
+        CAutoLock lock(this);
+
+        return m_allowBitstreaming;
+    }
+
+    STDMETHODIMP_(void) Settings::SetCrossfeedEnabled(BOOL bEnable)
+    {
+        CAutoLock lock(this);
+
+        if (m_crossfeedEnabled != bEnable)
+        {
+            m_crossfeedEnabled = bEnable;
+            m_serial++;
+        }
+    }
+
+    STDMETHODIMP_(BOOL) Settings::GetCrossfeedEnabled()
+    {
+        CAutoLock lock(this);
+
+        return m_crossfeedEnabled;
+    }
+
+    STDMETHODIMP Settings::SetCrossfeedSettings(UINT32 uCutoffFrequency, UINT32 uCrossfeedLevel)
+    {
+        if (uCutoffFrequency < CROSSFEED_CUTOFF_FREQ_MIN ||
+            uCutoffFrequency > CROSSFEED_CUTOFF_FREQ_MAX ||
+            uCrossfeedLevel < CROSSFEED_LEVEL_MIN ||
+            uCrossfeedLevel > CROSSFEED_LEVEL_MAX)
+        {
+            return E_INVALIDARG;
+        }
+
+        CAutoLock lock(this);
+
+        if (m_crossfeedCutoffFrequency != uCutoffFrequency ||
+            m_crossfeedLevel != uCrossfeedLevel)
+        {
+            m_crossfeedCutoffFrequency = uCutoffFrequency;
+            m_crossfeedLevel = uCrossfeedLevel;
+            m_serial++;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(void) Settings::GetCrossfeedSettings(UINT32* puCutoffFrequency, UINT32* puCrossfeedLevel)
+    {
+        CAutoLock lock(this);
+
+        if (puCutoffFrequency)
+            *puCutoffFrequency = m_crossfeedCutoffFrequency;
+
+        if (puCrossfeedLevel)
+            *puCrossfeedLevel = m_crossfeedLevel;
+    }
+
+    STDMETHODIMP_(void) Settings::SetIgnoreSystemChannelMixer(BOOL bEnable)
+    {
+        CAutoLock lock(this);
+
+        if (m_ignoreSystemChannelMixer != bEnable)
+        {
+            m_ignoreSystemChannelMixer = bEnable;
+            m_serial++;
+        }
+    }
+
+    STDMETHODIMP_(BOOL) Settings::GetIgnoreSystemChannelMixer()
+    {
+        CAutoLock lock(this);
+
+        return m_ignoreSystemChannelMixer;
+    }
+
+    STDMETHODIMP Settings::SetTimestretchSettings(UINT32 uTimestretchMethod)
+    {
+        if (uTimestretchMethod != TIMESTRETCH_METHOD_SOLA &&
+            uTimestretchMethod != TIMESTRETCH_METHOD_PHASE_VOCODER)
+        {
+            return E_INVALIDARG;
+        }
+
+    #ifndef SANEAR_GPL_PHASE_VOCODER
+        if (uTimestretchMethod == TIMESTRETCH_METHOD_PHASE_VOCODER)
+            return E_NOTIMPL;
+    #endif
+
+        CAutoLock lock(this);
+
+        if (uTimestretchMethod != m_timestretchMethod)
+        {
+            m_timestretchMethod = uTimestretchMethod;
+            m_serial++;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(void) Settings::GetTimestretchSettings(UINT32* puTimestretchMethod)
+    {
+        CAutoLock lock(this);
+
+        if (puTimestretchMethod)
+            *puTimestretchMethod = m_timestretchMethod;
+    }
+
+    STDMETHODIMP Settings::SetHeadlessDevice(UINT32 uDevice, LPCWSTR pFilePath, UINT32 uSpeedPercent)
+    {
+        if (uDevice != HEADLESS_DEVICE_NONE &&
+            uDevice != HEADLESS_DEVICE_NULL &&
+            uDevice != HEADLESS_DEVICE_FILE &&
+            uDevice != HEADLESS_DEVICE_SIMULATED)
+        {
+            return E_INVALIDARG;
+        }
+
+        if (uDevice == HEADLESS_DEVICE_FILE && (!pFilePath || !*pFilePath))
+            return E_INVALIDARG;
+
+        if (uSpeedPercent > HEADLESS_DEVICE_SPEED_MAX)
+            return E_INVALIDARG;
+
+        CAutoLock lock(this);
+
+        if (m_headlessDevice != uDevice ||
+            m_headlessSpeed != uSpeedPercent ||
+            (pFilePath && m_headlessFilePath != pFilePath) ||
+            (!pFilePath && !m_headlessFilePath.empty()))
+        {
+            try
+            {
+                m_headlessFilePath = pFilePath ? pFilePath : L"";
+                m_headlessDevice = uDevice;
+                m_headlessSpeed = uSpeedPercent;
+                m_serial++;
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP Settings::GetHeadlessDevice(UINT32* puDevice, LPWSTR* ppFilePath, UINT32* puSpeedPercent)
+    {
+        CAutoLock lock(this);
+
+        if (puDevice)
+            *puDevice = m_headlessDevice;
+
+        if (ppFilePath)
+        {
+            size_t size = sizeof(wchar_t) * (m_headlessFilePath.length() + 1);
+
+            *ppFilePath = static_cast<LPWSTR>(CoTaskMemAlloc(size));
+
+            if (!*ppFilePath)
+                return E_OUTOFMEMORY;
+
+            memcpy(*ppFilePath, m_headlessFilePath.c_str(), size);
+        }
+
+        if (puSpeedPercent)
+            *puSpeedPercent = m_headlessSpeed;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP Settings::SetSimulatedDeviceSettings(UINT32 uPeriodUs, INT32 iDriftPpm,
+                                                      UINT32 uPositionJitterUs, UINT32 uEventJitterUs)
+    {
+        if (uPeriodUs < SIMULATED_DEVICE_PERIOD_MIN_US || uPeriodUs > SIMULATED_DEVICE_PERIOD_MAX_US)
+            return E_INVALIDARG;
+
+        if (iDriftPpm < -SIMULATED_DEVICE_DRIFT_MAX_PPM || iDriftPpm > SIMULATED_DEVICE_DRIFT_MAX_PPM)
+            return E_INVALIDARG;
+
+        // Events jittering past the neighbouring ones wouldn't resemble any hardware.
+        if (uEventJitterUs >= uPeriodUs / 2)
+            return E_INVALIDARG;
+
+        CAutoLock lock(this);
+
+        if (m_simulatedPeriod != uPeriodUs ||
+            m_simulatedDrift != iDriftPpm ||
+            m_simulatedPositionJitter != uPositionJitterUs ||
+            m_simulatedEventJitter != uEventJitterUs)
+        {
+            m_simulatedPeriod = uPeriodUs;
+            m_simulatedDrift = iDriftPpm;
+            m_simulatedPositionJitter = uPositionJitterUs;
+            m_simulatedEventJitter = uEventJitterUs;
+            m_serial++;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(void) Settings::GetSimulatedDeviceSettings(UINT32* puPeriodUs, INT32* piDriftPpm,
+                                                             UINT32* puPositionJitterUs, UINT32* puEventJitterUs)
+    {
+        CAutoLock lock(this);
+
+        if (puPeriodUs)
+            *puPeriodUs = m_simulatedPeriod;
+
+        if (piDriftPpm)
+            *piDriftPpm = m_simulatedDrift;
+
+        if (puPositionJitterUs)
+            *puPositionJitterUs = m_simulatedPositionJitter;
+
+        if (puEventJitterUs)
+            *puEventJitterUs = m_simulatedEventJitter;
+    }
+
+    STDMETHODIMP_(void) Settings::SetExclusivePauseSilence(BOOL bEnable)
+    {
+        CAutoLock lock(this);
+
+        if (m_exclusivePauseSilence != bEnable)
+        {
+            m_exclusivePauseSilence = bEnable;
+            m_serial++;
+        }
+    }
+
+    STDMETHODIMP_(BOOL) Settings::GetExclusivePauseSilence()
+    {
+        CAutoLock lock(this);
+
+        return m_exclusivePauseSilence;
+    }
+
+    STDMETHODIMP_(void) Settings::SetAdaptiveBuffer(BOOL bEnable)
+    {
+        CAutoLock lock(this);
+
+        if (m_adaptiveBuffer != bEnable)
+        {
+            m_adaptiveBuffer = bEnable;
+            m_serial++;
+        }
+    }
+
+    STDMETHODIMP_(BOOL) Settings::GetAdaptiveBuffer()
+    {
+        CAutoLock lock(this);
+
+        return m_adaptiveBuffer;
+    }
+
+    STDMETHODIMP Settings::SetLowLatencyPeriod(UINT32 uPeriodUs)
+    {
+        if (uPeriodUs != LOW_LATENCY_PERIOD_OFF &&
+            (uPeriodUs < LOW_LATENCY_PERIOD_MIN_US || uPeriodUs > LOW_LATENCY_PERIOD_MAX_US))
+        {
+            return E_INVALIDARG;
+        }
+
+        CAutoLock lock(this);
+
+        if (m_lowLatencyPeriod != uPeriodUs)
+        {
+            m_lowLatencyPeriod = uPeriodUs;
+            m_serial++;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(UINT32) Settings::GetLowLatencyPeriod()
+    {
+        CAutoLock lock(this);
+
+        return m_lowLatencyPeriod;
+    }
+
+    STDMETHODIMP_(void) Settings::SetPullMode(BOOL bEnable)
+    {
+        CAutoLock lock(this);
+
+        if (m_pullMode != bEnable)
+        {
+            m_pullMode = bEnable;
+            m_serial++;
+        }
+    }
+
+    STDMETHODIMP_(BOOL) Settings::GetPullMode()
+    {
+        CAutoLock lock(this);
+
+        return m_pullMode;
+    }
+
+    STDMETHODIMP Settings::SetLiveTargetLatency(UINT32 uLatencyMs)
+    {
+        if (uLatencyMs != LIVE_TARGET_LATENCY_AUTO &&
+            (uLatencyMs < LIVE_TARGET_LATENCY_MIN_MS || uLatencyMs > LIVE_TARGET_LATENCY_MAX_MS))
+        {
+            return E_INVALIDARG;
+        }
+
+        CAutoLock lock(this);
+
+        if (m_liveTargetLatency != uLatencyMs)
+        {
+            m_liveTargetLatency = uLatencyMs;
+            m_serial++;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(UINT32) Settings::GetLiveTargetLatency()
+    {
+        CAutoLock lock(this);
+
+        return m_liveTargetLatency;
+    }
+
+    STDMETHODIMP Settings::SetStartPrebuffer(UINT32 uPeriods)
+    {
+        if (uPeriods != START_PREBUFFER_FULL &&
+            (uPeriods < START_PREBUFFER_MIN_PERIODS || uPeriods > START_PREBUFFER_MAX_PERIODS))
+        {
+            return E_INVALIDARG;
+        }
+
+        CAutoLock lock(this);
+
+        if (m_startPrebuffer != uPeriods)
+        {
+            m_startPrebuffer = uPeriods;
+            m_serial++;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP_(UINT32) Settings::GetStartPrebuffer()
+    {
+        CAutoLock lock(this);
+
+        return m_startPrebuffer;
+    }
+}
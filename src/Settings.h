@@ -1,67 +1,114 @@
-#pragma once
-
-#include "Interfaces.h"
-
-namespace SaneAudioRenderer
-{
-    class Settings final
-        : public CUnknown
-        , public ISettings
-        , private CCritSec
-    {
-    public:
-
-        DECLARE_IUNKNOWN
-
-        Settings(IUnknown* pUnknown);
-        Settings(const Settings&) = delete;
-        Settings& operator=(const Settings&) = delete;
-
-        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
-
-        STDMETHODIMP_(UINT32) GetSerial() override;
-
-        STDMETHODIMP SetOuputDevice(LPCWSTR pDeviceId, BOOL bExclusive, UINT32 uBufferMS) override;
-        STDMETHODIMP GetOuputDevice(LPWSTR* ppDeviceId, BOOL* pbExclusive, UINT32* puBufferMS) override;
-
-        STDMETHODIMP_(void) SetAllowBitstreaming(BOOL bAllowBitstreaming) override;
-        STDMETHODIMP_(BOOL) GetAllowBitstreaming() override;
-
-        STDMETHODIMP_(void) SetCrossfeedEnabled(BOOL bEnable) override;
-        STDMETHODIMP_(BOOL) GetCrossfeedEnabled() override;
-
-        STDMETHODIMP SetCrossfeedSettings(UINT32 uCutoffFrequency, UINT32 uCrossfeedLevel) override;
-        STDMETHODIMP_(void) GetCrossfeedSettings(UINT32* puCutoffFrequency, UINT32* puCrossfeedLevel) override;
-
-        STDMETHODIMP_(void) SetIgnoreSystemChannelMixer(BOOL bEnable) override;
-        STDMETHODIMP_(BOOL) GetIgnoreSystemChannelMixer() override;
-
-        STDMETHODIMP SetTimestretchSettings(UINT32 uTimestretchMethod) override;
-        STDMETHODIMP_(void) GetTimestretchSettings(UINT32* puTimestretchMethod) override;
-
-    private:
-
-        std::atomic<UINT32> m_serial = 0;
-
-        std::wstring m_deviceId;
-        BOOL m_exclusive = FALSE;
-        UINT32 m_buffer = OUTPUT_DEVICE_BUFFER_DEFAULT_MS;
-
-        BOOL m_allowBitstreaming = TRUE;
-
-        BOOL m_sharedModePeakLimiterEnabled = FALSE;
-
-        BOOL m_crossfeedEnabled = FALSE;
-        UINT32 m_crossfeedCutoffFrequency = CROSSFEED_CUTOFF_FREQ_CMOY;
-        UINT32 m_crossfeedLevel = CROSSFEED_LEVEL_CMOY;
-
-        BOOL m_ignoreSystemChannelMixer = TRUE;
-
-        UINT32 m_timestretchMethod =
-    #ifdef SANEAR_GPL_PHASE_VOCODER
-                   TIMESTRETCH_METHOD_PHASE_VOCODER;
-    #else
-                   TIMESTRETCH_METHOD_SOLA;
-    #endif
-    };
-}
+#pragma once
+
+#include "Interfaces.h"
+
+namespace SaneAudioRenderer
+{
+    class Settings final
+        : public CUnknown
+        , public ISettings2
+        , private CCritSec
+    {
+    public:
+
+        DECLARE_IUNKNOWN
+
+        Settings(IUnknown* pUnknown);
+        Settings(const Settings&) = delete;
+        Settings& operator=(const Settings&) = delete;
+
+        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
+
+        STDMETHODIMP_(UINT32) GetSerial() override;
+
+        STDMETHODIMP SetOuputDevice(LPCWSTR pDeviceId, BOOL bExclusive, UINT32 uBufferMS) override;
+        STDMETHODIMP GetOuputDevice(LPWSTR* ppDeviceId, BOOL* pbExclusive, UINT32* puBufferMS) override;
+
+        STDMETHODIMP_(void) SetAllowBitstreaming(BOOL bAllowBitstreaming) override;
+        STDMETHODIMP_(BOOL) GetAllowBitstreaming() override;
+
+        STDMETHODIMP_(void) SetCrossfeedEnabled(BOOL bEnable) override;
+        STDMETHODIMP_(BOOL) GetCrossfeedEnabled() override;
+
+        STDMETHODIMP SetCrossfeedSettings(UINT32 uCutoffFrequency, UINT32 uCrossfeedLevel) override;
+        STDMETHODIMP_(void) GetCrossfeedSettings(UINT32* puCutoffFrequency, UINT32* puCrossfeedLevel) override;
+
+        STDMETHODIMP_(void) SetIgnoreSystemChannelMixer(BOOL bEnable) override;
+        STDMETHODIMP_(BOOL) GetIgnoreSystemChannelMixer() override;
+
+        STDMETHODIMP SetTimestretchSettings(UINT32 uTimestretchMethod) override;
+        STDMETHODIMP_(void) GetTimestretchSettings(UINT32* puTimestretchMethod) override;
+
+        STDMETHODIMP SetHeadlessDevice(UINT32 uDevice, LPCWSTR pFilePath, UINT32 uSpeedPercent) override;
+        STDMETHODIMP GetHeadlessDevice(UINT32* puDevice, LPWSTR* ppFilePath, UINT32* puSpeedPercent) override;
+
+        STDMETHODIMP SetSimulatedDeviceSettings(UINT32 uPeriodUs, INT32 iDriftPpm,
+                                                UINT32 uPositionJitterUs, UINT32 uEventJitterUs) override;
+        STDMETHODIMP_(void) GetSimulatedDeviceSettings(UINT32* puPeriodUs, INT32* piDriftPpm,
+                                                       UINT32* puPositionJitterUs, UINT32* puEventJitterUs) override;
+
+        STDMETHODIMP_(void) SetExclusivePauseSilence(BOOL bEnable) override;
+        STDMETHODIMP_(BOOL) GetExclusivePauseSilence() override;
+
+        STDMETHODIMP_(void) SetAdaptiveBuffer(BOOL bEnable) override;
+        STDMETHODIMP_(BOOL) GetAdaptiveBuffer() override;
+
+        STDMETHODIMP SetLowLatencyPeriod(UINT32 uPeriodUs) override;
+        STDMETHODIMP_(UINT32) GetLowLatencyPeriod() override;
+
+        STDMETHODIMP_(void) SetPullMode(BOOL bEnable) override;
+        STDMETHODIMP_(BOOL) GetPullMode() override;
+
+        STDMETHODIMP SetLiveTargetLatency(UINT32 uLatencyMs) override;
+        STDMETHODIMP_(UINT32) GetLiveTargetLatency() override;
+
+        STDMETHODIMP SetStartPrebuffer(UINT32 uPeriods) override;
+        STDMETHODIMP_(UINT32) GetStartPrebuffer() override;
+
+    private:
+
+        std::atomic<UINT32> m_serial = 0;
+
+        std::wstring m_deviceId;
+        BOOL m_exclusive = FALSE;
+        UINT32 m_buffer = OUTPUT_DEVICE_BUFFER_DEFAULT_MS;
+
+        BOOL m_allowBitstreaming = TRUE;
+
+        BOOL m_sharedModePeakLimiterEnabled = FALSE;
+
+        BOOL m_crossfeedEnabled = FALSE;
+        UINT32 m_crossfeedCutoffFrequency = CROSSFEED_CUTOFF_FREQ_CMOY;
+        UINT32 m_crossfeedLevel = CROSSFEED_LEVEL_CMOY;
+
+        BOOL m_ignoreSystemChannelMixer = TRUE;
+
+        UINT32 m_timestretchMethod =
+    #ifdef SANEAR_GPL_PHASE_VOCODER
+                   TIMESTRETCH_METHOD_PHASE_VOCODER;
+    #else
+                   TIMESTRETCH_METHOD_SOLA;
+    #endif
+
+        UINT32 m_headlessDevice = HEADLESS_DEVICE_NONE;
+        std::wstring m_headlessFilePath;
+        UINT32 m_headlessSpeed = HEADLESS_DEVICE_SPEED_REALTIME;
+
+        UINT32 m_simulatedPeriod = SIMULATED_DEVICE_PERIOD_DEFAULT_US;
+        INT32 m_simulatedDrift = 0;
+        UINT32 m_simulatedPositionJitter = 0;
+        UINT32 m_simulatedEventJitter = 0;
+
+        BOOL m_exclusivePauseSilence = FALSE;
+
+        BOOL m_adaptiveBuffer = FALSE;
+
+        UINT32 m_lowLatencyPeriod = LOW_LATENCY_PERIOD_OFF;
+
+        BOOL m_pullMode = FALSE;
+
+        UINT32 m_liveTargetLatency = LIVE_TARGET_LATENCY_AUTO;
+
+        UINT32 m_startPrebuffer = START_PREBUFFER_FULL;
+    };
+}
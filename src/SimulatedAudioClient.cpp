@@ -0,0 +1,479 @@
+#include "pch.h"
+#include "SimulatedAudioClient.h"
+
+#include "DspFormat.h"
+#include "Interfaces.h"
+
+namespace SaneAudioRenderer
+{
+    namespace
+    {
+        const uint32_t MixRate = 48000;
+        const uint32_t MixChannels = 2;
+    }
+
+    SimulatedAudioClient::SimulatedAudioClient(const SimulatedAudioParameters& parameters)
+        : CUnknown("SaneAudioRenderer::SimulatedAudioClient", nullptr)
+        , m_parameters(parameters)
+    {
+        assert(m_parameters.period > 0);
+
+        if (static_cast<HANDLE>(m_wake) == NULL)
+            throw E_OUTOFMEMORY;
+    }
+
+    SimulatedAudioClient::~SimulatedAudioClient()
+    {
+        m_exit = true;
+        m_wake.Set();
+
+        if (m_thread.joinable())
+            m_thread.join();
+
+        DebugOut(ClassName(this), "destroy after", m_underruns, "underruns");
+    }
+
+    STDMETHODIMP SimulatedAudioClient::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == __uuidof(IAudioClient))
+            return GetInterface(static_cast<IAudioClient*>(this), ppv);
+
+        return CUnknown::NonDelegatingQueryInterface(riid, ppv);
+    }
+
+    STDMETHODIMP SimulatedAudioClient::Initialize(AUDCLNT_SHAREMODE shareMode, DWORD streamFlags,
+                                                  REFERENCE_TIME bufferDuration, REFERENCE_TIME periodicity,
+                                                  const WAVEFORMATEX* pFormat, LPCGUID)
+    {
+        CheckPointer(pFormat, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (m_initialized)
+            return AUDCLNT_E_ALREADY_INITIALIZED;
+
+        ReturnIfFailed(IsFormatSupported(shareMode, pFormat, nullptr));
+
+        m_exclusive = (shareMode == AUDCLNT_SHAREMODE_EXCLUSIVE);
+        m_eventMode = !!(streamFlags & AUDCLNT_STREAMFLAGS_EVENTCALLBACK);
+
+        if (m_exclusive && m_eventMode && bufferDuration != periodicity)
+            return E_INVALIDARG;
+
+        try
+        {
+            m_rate = pFormat->nSamplesPerSec;
+
+            // Buffer can't be shorter than device period, and exclusive event mode is double buffered.
+            m_bufferFrames = (UINT32)TimeToFrames(std::max(bufferDuration, m_parameters.period), m_rate);
+            m_bufferCapacity = (m_exclusive && m_eventMode) ? 2 * m_bufferFrames : m_bufferFrames;
+
+            m_data.resize(m_bufferCapacity * pFormat->nBlockAlign);
+
+            m_clock = new SimulatedAudioClock(m_rate, ISettings2::HEADLESS_DEVICE_SPEED_REALTIME, m_parameters.driftPpm,
+                                              TimeToFrames(m_parameters.positionJitter, m_rate));
+            m_clock->NonDelegatingAddRef();
+            HRESULT result = m_clock->NonDelegatingQueryInterface(IID_PPV_ARGS(&m_clockHolder));
+            m_clock->NonDelegatingRelease();
+            ReturnIfFailed(result);
+
+            if (m_eventMode)
+                m_thread = std::thread(std::bind(&SimulatedAudioClient::EventFeed, this));
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+        catch (std::system_error&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        m_initialized = true;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::GetBufferSize(UINT32* pNumBufferFrames)
+    {
+        CheckPointer(pNumBufferFrames, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        *pNumBufferFrames = m_bufferFrames;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::GetStreamLatency(REFERENCE_TIME* pLatency)
+    {
+        CheckPointer(pLatency, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        *pLatency = m_parameters.period;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::GetCurrentPadding(UINT32* pNumPaddingFrames)
+    {
+        CheckPointer(pNumPaddingFrames, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        *pNumPaddingFrames = GetPadding();
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::IsFormatSupported(AUDCLNT_SHAREMODE shareMode, const WAVEFORMATEX* pFormat,
+                                                         WAVEFORMATEX** ppClosestMatch)
+    {
+        CheckPointer(pFormat, E_POINTER);
+
+        if (ppClosestMatch)
+            *ppClosestMatch = nullptr;
+
+        if (pFormat->nChannels == 0 ||
+            pFormat->nSamplesPerSec == 0 ||
+            pFormat->nBlockAlign == 0)
+        {
+            return E_INVALIDARG;
+        }
+
+        // Shared mode engine mixes float at a fixed rate, channel layouts go through the system mixer.
+        if (shareMode == AUDCLNT_SHAREMODE_SHARED &&
+            (pFormat->nSamplesPerSec != MixRate || DspFormatFromWaveFormat(*pFormat) != DspFormat::Float))
+        {
+            return AUDCLNT_E_UNSUPPORTED_FORMAT;
+        }
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::GetMixFormat(WAVEFORMATEX** ppDeviceFormat)
+    {
+        CheckPointer(ppDeviceFormat, E_POINTER);
+
+        auto pFormat = static_cast<WAVEFORMATEXTENSIBLE*>(CoTaskMemAlloc(sizeof(WAVEFORMATEXTENSIBLE)));
+
+        if (!pFormat)
+            return E_OUTOFMEMORY;
+
+        pFormat->Format.wFormatTag      = WAVE_FORMAT_EXTENSIBLE;
+        pFormat->Format.nChannels       = MixChannels;
+        pFormat->Format.nSamplesPerSec  = MixRate;
+        pFormat->Format.nAvgBytesPerSec = MixRate * MixChannels * 4;
+        pFormat->Format.nBlockAlign     = MixChannels * 4;
+        pFormat->Format.wBitsPerSample  = 32;
+        pFormat->Format.cbSize          = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+        pFormat->Samples.wValidBitsPerSample = 32;
+        pFormat->dwChannelMask          = KSAUDIO_SPEAKER_STEREO;
+        pFormat->SubFormat              = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+
+        *ppDeviceFormat = &pFormat->Format;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::GetDevicePeriod(REFERENCE_TIME* pDefaultPeriod, REFERENCE_TIME* pMinimumPeriod)
+    {
+        if (pDefaultPeriod)
+            *pDefaultPeriod = m_parameters.period;
+
+        if (pMinimumPeriod)
+            *pMinimumPeriod = m_parameters.period;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::Start()
+    {
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        if (m_running)
+            return AUDCLNT_E_NOT_STOPPED;
+
+        if (m_eventMode && !m_event)
+            return AUDCLNT_E_EVENTHANDLE_NOT_SET;
+
+        m_clock->Start();
+        m_running = true;
+
+        m_eventCounter = GetPerformanceCounter();
+        m_wake.Set();
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::Stop()
+    {
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        if (!m_running)
+            return S_FALSE;
+
+        // Account for underruns up to this point.
+        GetPadding();
+
+        m_clock->Stop();
+        m_running = false;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::Reset()
+    {
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        if (m_running)
+            return AUDCLNT_E_NOT_STOPPED;
+
+        m_clock->Reset();
+        m_writtenFrames = 0;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::SetEventHandle(HANDLE eventHandle)
+    {
+        CAutoLock lock(this);
+
+        if (!m_initialized)
+            return AUDCLNT_E_NOT_INITIALIZED;
+
+        if (!m_eventMode)
+            return AUDCLNT_E_EVENTHANDLE_NOT_EXPECTED;
+
+        m_event = eventHandle;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClient::GetService(REFIID riid, void** ppv)
+    {
+        CheckPointer(ppv, E_POINTER);
+
+        {
+            CAutoLock lock(this);
+
+            if (!m_initialized)
+                return AUDCLNT_E_NOT_INITIALIZED;
+        }
+
+        try
+        {
+            if (riid == __uuidof(IAudioRenderClient))
+            {
+                auto pService = new SimulatedAudioRenderClient(this);
+                pService->NonDelegatingAddRef();
+                HRESULT result = pService->NonDelegatingQueryInterface(riid, ppv);
+                pService->NonDelegatingRelease();
+                return result;
+            }
+
+            if (riid == __uuidof(IAudioClock))
+            {
+                auto pService = new SimulatedAudioClockService(this);
+                pService->NonDelegatingAddRef();
+                HRESULT result = pService->NonDelegatingQueryInterface(riid, ppv);
+                pService->NonDelegatingRelease();
+                return result;
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        return E_NOINTERFACE;
+    }
+
+    HRESULT SimulatedAudioClient::GetBuffer(UINT32 frames, BYTE** ppData)
+    {
+        CheckPointer(ppData, E_POINTER);
+
+        CAutoLock lock(this);
+
+        if (m_requestedFrames > 0)
+            return AUDCLNT_E_OUT_OF_ORDER;
+
+        // Exclusive event mode client is trusted to stay within its half of the buffer.
+        if (frames > m_bufferCapacity ||
+            (!(m_exclusive && m_eventMode) && frames > m_bufferCapacity - GetPadding()))
+        {
+            return AUDCLNT_E_BUFFER_TOO_LARGE;
+        }
+
+        m_requestedFrames = frames;
+        *ppData = m_data.data();
+
+        return S_OK;
+    }
+
+    HRESULT SimulatedAudioClient::ReleaseBuffer(UINT32 frames, DWORD)
+    {
+        CAutoLock lock(this);
+
+        if (frames > m_requestedFrames)
+            return AUDCLNT_E_INVALID_SIZE;
+
+        m_requestedFrames = 0;
+        m_writtenFrames += frames;
+
+        return S_OK;
+    }
+
+    HRESULT SimulatedAudioClient::GetClockFrequency(UINT64* pFrequency)
+    {
+        return m_clock->GetFrequency(pFrequency);
+    }
+
+    HRESULT SimulatedAudioClient::GetClockPosition(UINT64* pPosition, UINT64* pQPCPosition)
+    {
+        return m_clock->GetPosition(pPosition, pQPCPosition);
+    }
+
+    void SimulatedAudioClient::EventFeed()
+    {
+        TimePeriodHelper timePeriodHelper(1);
+
+        std::minstd_rand random;
+
+        // Events follow device time, which is skewed by drift.
+        const int64_t frequency = GetPerformanceFrequency();
+        const int64_t period = (int64_t)(m_parameters.period * frequency / (double)OneSecond /
+                                         (1. + m_parameters.driftPpm / 1000000.));
+        const int64_t jitter = llMulDiv(m_parameters.eventJitter, frequency, OneSecond, 0);
+
+        int64_t deviation = 0;
+
+        while (!m_exit)
+        {
+            DWORD waitTime = INFINITE;
+
+            {
+                CAutoLock lock(this);
+
+                if (m_running && m_event)
+                {
+                    const int64_t counter = GetPerformanceCounter();
+
+                    if (counter >= m_eventCounter + deviation)
+                    {
+                        SetEvent(m_event);
+
+                        m_eventCounter += period;
+                        deviation = (jitter > 0) ? (int64_t)(random() % (2 * jitter + 1)) - jitter : 0;
+
+                        waitTime = 0;
+                    }
+                    else
+                    {
+                        waitTime = (DWORD)llMulDiv(m_eventCounter + deviation - counter, 1000, frequency, 0);
+                    }
+                }
+            }
+
+            m_wake.Wait(waitTime);
+        }
+    }
+
+    UINT32 SimulatedAudioClient::GetPadding()
+    {
+        assert(CritCheckIn(this));
+
+        const uint64_t clockFrames = m_clock->GetFrames();
+
+        if (clockFrames > m_writtenFrames)
+        {
+            // Starved, the device has been playing silence meanwhile.
+            if (m_writtenFrames > 0)
+                m_underruns++;
+
+            m_writtenFrames = clockFrames;
+        }
+
+        return (UINT32)std::min<uint64_t>(m_writtenFrames - clockFrames, m_bufferCapacity);
+    }
+
+    SimulatedAudioRenderClient::SimulatedAudioRenderClient(SimulatedAudioClient* pClient)
+        : CUnknown("SaneAudioRenderer::SimulatedAudioRenderClient", nullptr)
+        , m_holder(pClient)
+        , m_client(pClient)
+    {
+        assert(m_client);
+    }
+
+    STDMETHODIMP SimulatedAudioRenderClient::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == __uuidof(IAudioRenderClient))
+            return GetInterface(static_cast<IAudioRenderClient*>(this), ppv);
+
+        return CUnknown::NonDelegatingQueryInterface(riid, ppv);
+    }
+
+    STDMETHODIMP SimulatedAudioRenderClient::GetBuffer(UINT32 frames, BYTE** ppData)
+    {
+        return m_client->GetBuffer(frames, ppData);
+    }
+
+    STDMETHODIMP SimulatedAudioRenderClient::ReleaseBuffer(UINT32 frames, DWORD flags)
+    {
+        return m_client->ReleaseBuffer(frames, flags);
+    }
+
+    SimulatedAudioClockService::SimulatedAudioClockService(SimulatedAudioClient* pClient)
+        : CUnknown("SaneAudioRenderer::SimulatedAudioClockService", nullptr)
+        , m_holder(pClient)
+        , m_client(pClient)
+    {
+        assert(m_client);
+    }
+
+    STDMETHODIMP SimulatedAudioClockService::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == __uuidof(IAudioClock))
+            return GetInterface(static_cast<IAudioClock*>(this), ppv);
+
+        return CUnknown::NonDelegatingQueryInterface(riid, ppv);
+    }
+
+    STDMETHODIMP SimulatedAudioClockService::GetFrequency(UINT64* pu64Frequency)
+    {
+        return m_client->GetClockFrequency(pu64Frequency);
+    }
+
+    STDMETHODIMP SimulatedAudioClockService::GetPosition(UINT64* pu64Position, UINT64* pu64QPCPosition)
+    {
+        return m_client->GetClockPosition(pu64Position, pu64QPCPosition);
+    }
+
+    STDMETHODIMP SimulatedAudioClockService::GetCharacteristics(DWORD* pdwCharacteristics)
+    {
+        CheckPointer(pdwCharacteristics, E_POINTER);
+
+        *pdwCharacteristics = AUDIOCLOCK_CHARACTERISTIC_FIXED_FREQ;
+
+        return S_OK;
+    }
+}
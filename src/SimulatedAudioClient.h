@@ -0,0 +1,131 @@
+#pragma once
+
+#include "SimulatedAudioClock.h"
+
+namespace SaneAudioRenderer
+{
+    struct SimulatedAudioParameters final
+    {
+        REFERENCE_TIME period;
+        int32_t        driftPpm;
+        REFERENCE_TIME positionJitter;
+        REFERENCE_TIME eventJitter;
+    };
+
+    // Stand-in for WASAPI endpoint, lets the device layer run without audio hardware.
+    // Consumes written frames at simulated clock pace and signals events every period.
+    class SimulatedAudioClient final
+        : public CUnknown
+        , public IAudioClient
+        , private CCritSec
+    {
+    public:
+
+        DECLARE_IUNKNOWN
+
+        SimulatedAudioClient(const SimulatedAudioParameters& parameters);
+        SimulatedAudioClient(const SimulatedAudioClient&) = delete;
+        SimulatedAudioClient& operator=(const SimulatedAudioClient&) = delete;
+        ~SimulatedAudioClient();
+
+        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
+
+        STDMETHODIMP Initialize(AUDCLNT_SHAREMODE shareMode, DWORD streamFlags, REFERENCE_TIME bufferDuration,
+                                REFERENCE_TIME periodicity, const WAVEFORMATEX* pFormat, LPCGUID pSessionGuid) override;
+        STDMETHODIMP GetBufferSize(UINT32* pNumBufferFrames) override;
+        STDMETHODIMP GetStreamLatency(REFERENCE_TIME* pLatency) override;
+        STDMETHODIMP GetCurrentPadding(UINT32* pNumPaddingFrames) override;
+        STDMETHODIMP IsFormatSupported(AUDCLNT_SHAREMODE shareMode, const WAVEFORMATEX* pFormat,
+                                       WAVEFORMATEX** ppClosestMatch) override;
+        STDMETHODIMP GetMixFormat(WAVEFORMATEX** ppDeviceFormat) override;
+        STDMETHODIMP GetDevicePeriod(REFERENCE_TIME* pDefaultPeriod, REFERENCE_TIME* pMinimumPeriod) override;
+        STDMETHODIMP Start() override;
+        STDMETHODIMP Stop() override;
+        STDMETHODIMP Reset() override;
+        STDMETHODIMP SetEventHandle(HANDLE eventHandle) override;
+        STDMETHODIMP GetService(REFIID riid, void** ppv) override;
+
+        HRESULT GetBuffer(UINT32 frames, BYTE** ppData);
+        HRESULT ReleaseBuffer(UINT32 frames, DWORD flags);
+
+        HRESULT GetClockFrequency(UINT64* pFrequency);
+        HRESULT GetClockPosition(UINT64* pPosition, UINT64* pQPCPosition);
+
+    private:
+
+        void EventFeed();
+
+        UINT32 GetPadding();
+
+        const SimulatedAudioParameters m_parameters;
+
+        bool m_initialized = false;
+        bool m_exclusive = false;
+        bool m_eventMode = false;
+        uint32_t m_rate = 0;
+        UINT32 m_bufferFrames = 0;
+        UINT32 m_bufferCapacity = 0;
+
+        IAudioClockPtr m_clockHolder;
+        SimulatedAudioClock* m_clock = nullptr;
+
+        std::vector<BYTE> m_data;
+        UINT32 m_requestedFrames = 0;
+        uint64_t m_writtenFrames = 0;
+        uint32_t m_underruns = 0;
+
+        std::thread m_thread;
+        CAMEvent m_wake;
+        std::atomic<bool> m_exit = false;
+        HANDLE m_event = NULL;
+        bool m_running = false;
+        int64_t m_eventCounter = 0;
+    };
+
+    class SimulatedAudioRenderClient final
+        : public CUnknown
+        , public IAudioRenderClient
+    {
+    public:
+
+        DECLARE_IUNKNOWN
+
+        SimulatedAudioRenderClient(SimulatedAudioClient* pClient);
+        SimulatedAudioRenderClient(const SimulatedAudioRenderClient&) = delete;
+        SimulatedAudioRenderClient& operator=(const SimulatedAudioRenderClient&) = delete;
+
+        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
+
+        STDMETHODIMP GetBuffer(UINT32 frames, BYTE** ppData) override;
+        STDMETHODIMP ReleaseBuffer(UINT32 frames, DWORD flags) override;
+
+    private:
+
+        IAudioClientPtr m_holder;
+        SimulatedAudioClient* const m_client;
+    };
+
+    class SimulatedAudioClockService final
+        : public CUnknown
+        , public IAudioClock
+    {
+    public:
+
+        DECLARE_IUNKNOWN
+
+        SimulatedAudioClockService(SimulatedAudioClient* pClient);
+        SimulatedAudioClockService(const SimulatedAudioClockService&) = delete;
+        SimulatedAudioClockService& operator=(const SimulatedAudioClockService&) = delete;
+
+        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
+
+        STDMETHODIMP GetFrequency(UINT64* pu64Frequency) override;
+        STDMETHODIMP GetPosition(UINT64* pu64Position, UINT64* pu64QPCPosition) override;
+        STDMETHODIMP GetCharacteristics(DWORD* pdwCharacteristics) override;
+
+    private:
+
+        IAudioClientPtr m_holder;
+        SimulatedAudioClient* const m_client;
+    };
+}
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "SimulatedAudioClock.h"
+
+namespace SaneAudioRenderer
+{
+    SimulatedAudioClock::SimulatedAudioClock(uint32_t rate, uint32_t speedPercent,
+                                             int32_t driftPpm, size_t jitterFrames)
+        : CUnknown("SaneAudioRenderer::SimulatedAudioClock", nullptr)
+        , m_rate(rate)
+        , m_speedPercent(speedPercent)
+        , m_multiplier(speedPercent / 100. * (1. + driftPpm / 1000000.))
+        , m_performanceFrequency(GetPerformanceFrequency())
+        , m_jitterFrames(jitterFrames)
+    {
+        assert(m_rate > 0);
+        m_counter = GetPerformanceCounter();
+    }
+
+    STDMETHODIMP SimulatedAudioClock::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+    {
+        if (riid == __uuidof(IAudioClock))
+            return GetInterface(static_cast<IAudioClock*>(this), ppv);
+
+        return CUnknown::NonDelegatingQueryInterface(riid, ppv);
+    }
+
+    STDMETHODIMP SimulatedAudioClock::GetFrequency(UINT64* pu64Frequency)
+    {
+        CheckPointer(pu64Frequency, E_POINTER);
+
+        *pu64Frequency = m_rate;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClock::GetPosition(UINT64* pu64Position, UINT64* pu64QPCPosition)
+    {
+        CheckPointer(pu64Position, E_POINTER);
+
+        CAutoLock lock(this);
+
+        // Free running clock is sampled now, otherwise at the moment of the last advance.
+        const int64_t counter = IsFreeRunning() ? GetPerformanceCounter() : m_counter;
+
+        uint64_t frames = GetFrames(counter);
+
+        if (m_jitterFrames > 0)
+        {
+            // Noisy but never going backwards, like the real thing.
+            int64_t noise = (int64_t)(m_random() % (2 * m_jitterFrames + 1)) - (int64_t)m_jitterFrames;
+            frames = (uint64_t)std::max<int64_t>((int64_t)frames + noise, 0);
+            frames = std::max(frames, m_reportedFrames);
+            m_reportedFrames = frames;
+        }
+
+        *pu64Position = frames;
+
+        if (pu64QPCPosition)
+            *pu64QPCPosition = llMulDiv(counter, OneSecond, m_performanceFrequency, 0);
+
+        return S_OK;
+    }
+
+    STDMETHODIMP SimulatedAudioClock::GetCharacteristics(DWORD* pdwCharacteristics)
+    {
+        CheckPointer(pdwCharacteristics, E_POINTER);
+
+        *pdwCharacteristics = AUDIOCLOCK_CHARACTERISTIC_FIXED_FREQ;
+
+        return S_OK;
+    }
+
+    void SimulatedAudioClock::Start()
+    {
+        CAutoLock lock(this);
+
+        if (!m_running)
+        {
+            m_counter = GetPerformanceCounter();
+            m_running = true;
+        }
+    }
+
+    void SimulatedAudioClock::Stop()
+    {
+        CAutoLock lock(this);
+
+        if (m_running)
+        {
+            const int64_t counter = GetPerformanceCounter();
+            m_frames = GetFrames(counter);
+            m_counter = counter;
+            m_running = false;
+        }
+    }
+
+    void SimulatedAudioClock::Reset()
+    {
+        CAutoLock lock(this);
+
+        m_frames = 0;
+        m_counter = GetPerformanceCounter();
+        m_reportedFrames = 0;
+    }
+
+    void SimulatedAudioClock::Advance(uint64_t frames)
+    {
+        CAutoLock lock(this);
+
+        assert(!IsFreeRunning());
+
+        if (m_running)
+        {
+            m_frames += frames;
+            m_counter = GetPerformanceCounter();
+        }
+    }
+
+    uint64_t SimulatedAudioClock::GetFrames()
+    {
+        CAutoLock lock(this);
+
+        return GetFrames(GetPerformanceCounter());
+    }
+
+    uint64_t SimulatedAudioClock::GetFrames(int64_t counter)
+    {
+        assert(CritCheckIn(this));
+
+        if (!m_running || !IsFreeRunning())
+            return m_frames;
+
+        const double seconds = (double)(counter - m_counter) / m_performanceFrequency;
+
+        return m_frames + (uint64_t)(seconds * m_rate * m_multiplier);
+    }
+}
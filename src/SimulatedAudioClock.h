@@ -0,0 +1,54 @@
+#pragma once
+
+namespace SaneAudioRenderer
+{
+    // IAudioClock of headless devices, counts frames at a fixed multiple of real time (skewed by drift),
+    // or as they are handed over with Advance() when the speed is zero. Reported positions can be
+    // made noisy with position jitter, GetFrames() is always exact.
+    class SimulatedAudioClock final
+        : public CUnknown
+        , public IAudioClock
+        , private CCritSec
+    {
+    public:
+
+        DECLARE_IUNKNOWN
+
+        SimulatedAudioClock(uint32_t rate, uint32_t speedPercent, int32_t driftPpm = 0, size_t jitterFrames = 0);
+        SimulatedAudioClock(const SimulatedAudioClock&) = delete;
+        SimulatedAudioClock& operator=(const SimulatedAudioClock&) = delete;
+
+        STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv) override;
+
+        STDMETHODIMP GetFrequency(UINT64* pu64Frequency) override;
+        STDMETHODIMP GetPosition(UINT64* pu64Position, UINT64* pu64QPCPosition) override;
+        STDMETHODIMP GetCharacteristics(DWORD* pdwCharacteristics) override;
+
+        void Start();
+        void Stop();
+        void Reset();
+
+        void Advance(uint64_t frames);
+
+        uint64_t GetFrames();
+
+        bool IsFreeRunning() const { return m_speedPercent != 0; }
+
+    private:
+
+        uint64_t GetFrames(int64_t counter);
+
+        const uint32_t m_rate;
+        const uint32_t m_speedPercent;
+        const double m_multiplier;
+        const int64_t m_performanceFrequency;
+
+        const size_t m_jitterFrames;
+        std::minstd_rand m_random;
+        uint64_t m_reportedFrames = 0;
+
+        bool m_running = false;
+        uint64_t m_frames = 0;
+        int64_t m_counter = 0;
+    };
+}